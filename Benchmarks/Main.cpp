@@ -0,0 +1,355 @@
+/*
+  ==============================================================================
+
+    This file contains the DSP micro-benchmarks, a console build that drives
+    NewProjectAudioProcessor headlessly and writes ns/sample and cycles/sample
+    as JSON. Compare two runs with compare.py next to this file.
+
+    Like the offline renderer, it is a console app compiling this file together
+    with the plugin's own sources; there are no build files for it in this
+    repository (see Tests/Main.cpp). Built with EQ_REALTIME_AUDIT=1 it can also
+    run the realtime safety audit (see RealtimeSafetyAudit.h).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <optional>
+#include "../PluginProcessor.h"
+#include "../Tests/RealtimeAuditSweep.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+namespace
+{
+    enum class Automation { none, designer, smoothed };
+
+    const char* getAutomationName(Automation automation)
+    {
+        switch (automation)
+        {
+        case Automation::designer:  return "automated";   // a parameter moves every block, the background designer follows
+        case Automation::smoothed:  return "smoothed";    // same, with 32 sample smoothing redesigning on the audio thread
+        case Automation::none:
+        default:                    return "static";
+        }
+    }
+
+    struct BenchmarkCase
+    {
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        Slope lowCutSlope = Slope24, highCutSlope = Slope24;
+        Automation automation = Automation::none;
+        int numChannels = 2;
+
+        juce::String getName() const
+        {
+            return "block:" + juce::String(blockSize) + "/rate:" + juce::String((int) sampleRate)
+                 + "/lowcut:" + juce::String(12 + 12 * (int) lowCutSlope) + "/highcut:" + juce::String(12 + 12 * (int) highCutSlope)
+                 + "/" + getAutomationName(automation) + "/channels:" + juce::String(numChannels);
+        }
+    };
+
+    struct Measurement
+    {
+        double nanosecondsPerSample = 0.0;   // per sample frame, all channels together
+        double cyclesPerSample = 0.0;
+    };
+
+    //==============================================================================
+    // the TSC counts at a constant reference rate rather than the core clock, so with turbo boost enabled
+    // cycles/sample is a time measure in cycle units, pin the clock for numbers that compare across machines
+    juce::int64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::int64) __rdtsc();
+       #else
+        return 0;
+       #endif
+    }
+
+    double getCyclesPerNanosecond()
+    {
+       #if JUCE_INTEL
+        // calibrate the counter against the high resolution clock once
+        const auto startTime = juce::Time::getHighResolutionTicks();
+        const auto startCycles = readCycleCounter();
+        juce::Thread::sleep(100);
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTime);
+        return (double) (readCycleCounter() - startCycles) / (seconds * 1.0e9);
+       #else
+        return juce::SystemStats::getCpuSpeedInMegahertz() * 1.0e-3;   // no portable cycle counter, estimate from the nominal clock
+       #endif
+    }
+
+    //==============================================================================
+    void setParameter(NewProjectAudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(parameterID);
+        jassert(parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // every band is active, otherwise the processor would skip the neutral ones and we'd be timing nothing
+    void setUpParameters(NewProjectAudioProcessor& processor, const BenchmarkCase& benchmark)
+    {
+        setParameter(processor, "LowCut Freq", 80.f);
+        setParameter(processor, "HighCut Freq", 12000.f);
+        setParameter(processor, "Peak Freq", 1000.f);
+        setParameter(processor, "Peak Gain", 3.f);
+        setParameter(processor, "Peak Quality", 1.f);
+        setParameter(processor, "LowCut Slope", (float) benchmark.lowCutSlope);
+        setParameter(processor, "HighCut Slope", (float) benchmark.highCutSlope);
+        setParameter(processor, "Smoothing", benchmark.automation == Automation::smoothed ? 2.f : 0.f);
+    }
+
+    // nothing if the processor won't take the case's channel count, rather than timing some other layout under its name
+    std::optional<Measurement> runCase(const BenchmarkCase& benchmark, double minimumSecondsPerRepetition, int numRepetitions, double cyclesPerNanosecond)
+    {
+        NewProjectAudioProcessor processor;
+        setUpParameters(processor, benchmark);
+
+        if (! processor.setMainBusLayout(juce::AudioChannelSet::canonicalChannelSet(benchmark.numChannels)))
+            return std::nullopt;
+
+        processor.setRateAndBufferSizeDetails(benchmark.sampleRate, benchmark.blockSize);
+        processor.prepareToPlay(benchmark.sampleRate, benchmark.blockSize);
+
+        // white noise from a fixed seed, refilled every block so the input never decays into the idle path
+        juce::AudioBuffer<float> source(benchmark.numChannels, benchmark.blockSize), buffer(benchmark.numChannels, benchmark.blockSize);
+        juce::Random random(0x5eed);
+
+        for (int channel = 0; channel < benchmark.numChannels; ++channel)
+            for (int i = 0; i < benchmark.blockSize; ++i)
+                source.setSample(channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+        juce::MidiBuffer midi;
+        int blockCounter = 0;
+
+        auto processOneBlock = [&]
+        {
+            if (benchmark.automation != Automation::none)   // a slow sweep across the peak range, moving every block
+                setParameter(processor, "Peak Freq", 200.f + 4000.f * (float) ((blockCounter++ % 256) / 255.0));
+
+            buffer.makeCopyOf(source, true);
+            processor.processBlock(buffer, midi);
+        };
+
+        const auto blocksPerRepetition = juce::jmax(16, (int) std::ceil(minimumSecondsPerRepetition * benchmark.sampleRate / benchmark.blockSize));
+
+        for (int i = 0; i < blocksPerRepetition / 4; ++i)   // warm up caches, the branch predictor and the designer
+            processOneBlock();
+
+        std::vector<Measurement> repetitions;
+
+        for (int repetition = 0; repetition < numRepetitions; ++repetition)
+        {
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            const auto startCycles = readCycleCounter();
+
+            for (int i = 0; i < blocksPerRepetition; ++i)
+                processOneBlock();
+
+            const auto endCycles = readCycleCounter();
+            const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+            const auto numSamples = (double) blocksPerRepetition * benchmark.blockSize;
+
+            Measurement measurement;
+            measurement.nanosecondsPerSample = seconds * 1.0e9 / numSamples;
+            measurement.cyclesPerSample = endCycles != startCycles ? (double) (endCycles - startCycles) / numSamples
+                                                                   : measurement.nanosecondsPerSample * cyclesPerNanosecond;
+            repetitions.push_back(measurement);
+        }
+
+        processor.releaseResources();
+
+        // the median is much steadier than the mean when the OS interrupts a repetition
+        std::sort(repetitions.begin(), repetitions.end(),
+                  [](const Measurement& a, const Measurement& b) { return a.nanosecondsPerSample < b.nanosecondsPerSample; });
+        return repetitions[repetitions.size() / 2];
+    }
+
+    //==============================================================================
+    // by default each dimension is swept on its own around a typical case, --full runs the whole cross product
+    std::vector<BenchmarkCase> makeCases(bool fullMatrix)
+    {
+        const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        const Slope slopes[] = { Slope12, Slope24, Slope36, Slope48 };
+        const Automation automations[] = { Automation::none, Automation::designer, Automation::smoothed };
+        const int channelCounts[] = { 1, 2, 8 };
+
+        std::vector<BenchmarkCase> cases;
+        const BenchmarkCase typical;
+
+        if (fullMatrix)
+        {
+            for (auto blockSize : blockSizes)
+                for (auto sampleRate : sampleRates)
+                    for (auto lowCutSlope : slopes)
+                        for (auto highCutSlope : slopes)
+                            for (auto automation : automations)
+                                for (auto numChannels : channelCounts)
+                                    cases.push_back({ blockSize, sampleRate, lowCutSlope, highCutSlope, automation, numChannels });
+            return cases;
+        }
+
+        auto addUnique = [&cases](const BenchmarkCase& benchmark)
+        {
+            for (auto& existing : cases)
+                if (existing.getName() == benchmark.getName())
+                    return;
+
+            cases.push_back(benchmark);
+        };
+
+        for (auto blockSize : blockSizes)      { auto c = typical; c.blockSize = blockSize;   addUnique(c); }
+        for (auto sampleRate : sampleRates)    { auto c = typical; c.sampleRate = sampleRate; addUnique(c); }
+        for (auto automation : automations)    { auto c = typical; c.automation = automation; addUnique(c); }
+        for (auto numChannels : channelCounts) { auto c = typical; c.numChannels = numChannels; addUnique(c); }
+
+        for (auto lowCutSlope : slopes)
+            for (auto highCutSlope : slopes)
+            {
+                auto c = typical;
+                c.lowCutSlope = lowCutSlope;
+                c.highCutSlope = highCutSlope;
+                addUnique(c);
+            }
+
+        return cases;
+    }
+
+    juce::var makeContext(double cyclesPerNanosecond, double minimumSeconds, int numRepetitions)
+    {
+        auto* context = new juce::DynamicObject();
+        context->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+        context->setProperty("cpu", juce::SystemStats::getCpuModel());
+        context->setProperty("num_cpus", juce::SystemStats::getNumCpus());
+        context->setProperty("juce_version", juce::SystemStats::getJUCEVersion());
+       #if JUCE_DEBUG
+        context->setProperty("build", "debug");   // not worth comparing, but better to say so than to hide it
+       #else
+        context->setProperty("build", "release");
+       #endif
+        context->setProperty("cycles_per_ns", cyclesPerNanosecond);
+        context->setProperty("min_seconds_per_repetition", minimumSeconds);
+        context->setProperty("repetitions", numRepetitions);
+        return context;
+    }
+
+    //==============================================================================
+    void runBenchmarks(const juce::ArgumentList& args)
+    {
+        const auto fullMatrix = args.containsOption("--full");
+        const auto filter = args.getValueForOption("--filter");
+        const auto minimumSeconds = args.containsOption("--min-time") ? args.getValueForOption("--min-time").getDoubleValue() : 0.2;
+        const auto numRepetitions = args.containsOption("--repetitions") ? juce::jmax(1, args.getValueForOption("--repetitions").getIntValue()) : 5;
+
+        const auto cyclesPerNanosecond = getCyclesPerNanosecond();
+        juce::Array<juce::var> results;
+        int numFailed = 0;
+
+        for (auto& benchmark : makeCases(fullMatrix))
+        {
+            const auto name = benchmark.getName();
+
+            if (filter.isNotEmpty() && ! name.contains(filter))
+                continue;
+
+            const auto result = runCase(benchmark, minimumSeconds, numRepetitions, cyclesPerNanosecond);
+
+            if (! result.has_value())
+            {
+                std::cerr << name << ": the processor doesn't support this channel layout" << std::endl;
+                ++numFailed;
+                continue;
+            }
+
+            const auto& measurement = *result;
+
+            std::cerr << name << ": " << juce::String(measurement.nanosecondsPerSample, 2) << " ns/sample, "
+                      << juce::String(measurement.cyclesPerSample, 1) << " cycles/sample" << std::endl;
+
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("name", name);
+            entry->setProperty("block_size", benchmark.blockSize);
+            entry->setProperty("sample_rate", benchmark.sampleRate);
+            entry->setProperty("low_cut_slope", 12 + 12 * (int) benchmark.lowCutSlope);
+            entry->setProperty("high_cut_slope", 12 + 12 * (int) benchmark.highCutSlope);
+            entry->setProperty("automation", getAutomationName(benchmark.automation));
+            entry->setProperty("channels", benchmark.numChannels);
+            entry->setProperty("ns_per_sample", measurement.nanosecondsPerSample);
+            entry->setProperty("cycles_per_sample", measurement.cyclesPerSample);
+            results.add(entry);
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("context", makeContext(cyclesPerNanosecond, minimumSeconds, numRepetitions));
+        root->setProperty("benchmarks", results);
+
+        const auto json = juce::JSON::toString(juce::var(root));
+
+        if (args.containsOption("--out|-o"))
+            args.getFileForOption("--out|-o").replaceWithText(json);
+        else
+            std::cout << json << std::endl;
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail(juce::String(numFailed) + " cases could not run");
+    }
+
+    void runRealtimeAudit(const juce::ArgumentList& args)
+    {
+        if (! RealtimeSafetyAudit::isEnabled)
+            juce::ConsoleApplication::fail("This build has no audit hooks, rebuild with EQ_REALTIME_AUDIT=1");
+
+        RealtimeSafetyAudit::setAbortOnViolation(args.containsOption("--abort"));
+        RealtimeSafetyAudit::resetViolations();
+
+        if (const auto numRefused = runRealtimeAuditSweeps(); numRefused > 0)
+            juce::ConsoleApplication::fail(juce::String(numRefused) + " audit sweeps could not set up their channel layout");
+
+        const auto numViolations = RealtimeSafetyAudit::getNumViolations();
+        std::cout << "realtime audit: " << numViolations << " violations" << std::endl;
+
+        if (numViolations > 0)
+            juce::ConsoleApplication::fail("processBlock is not realtime safe");
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+
+    app.addHelpCommand("--help|-h", "Usage: EQBenchmarks [options]\n"
+                                    "  --out, -o <file>          write the JSON results here instead of stdout\n"
+                                    "  --filter <text>           only run cases whose name contains the text, e.g. channels:8\n"
+                                    "  --full                    every combination instead of one sweep per dimension\n"
+                                    "  --min-time <seconds>      audio time per repetition, default 0.2\n"
+                                    "  --repetitions <n>         repetitions per case, the median is reported, default 5\n"
+                                    "\n"
+                                    "Compare two result files with: python3 compare.py baseline.json current.json\n"
+                                    "Check processBlock for allocations and locks with: EQBenchmarks --realtime-audit", true);
+
+    app.addCommand({ "--realtime-audit", "--realtime-audit [--abort]",
+                     "Runs parameter sweeps through processBlock with the realtime safety hooks armed",
+                     "Needs a build with EQ_REALTIME_AUDIT=1. Reports every allocation, lock or blocking call inside processBlock\n"
+                     "with a stack trace and fails if there was any, --abort stops at the first one.", runRealtimeAudit });
+
+    app.addDefaultCommand({ "", "[options]", "Runs the filter chain benchmarks", {}, runBenchmarks });
+
+    return app.findAndRunCommand(argc, argv);
+}
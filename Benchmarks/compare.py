@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+Compares two EQBenchmarks JSON files and flags the cases that got slower.
+
+    python3 compare.py baseline.json current.json [--threshold 5] [--metric ns_per_sample]
+
+Exits with 1 when any case regressed by more than the threshold (in percent),
+so it can gate a JUCE upgrade or a refactor in a local script.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data.get("context", {}), {b["name"]: b for b in data["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=5.0, help="allowed slowdown in percent (default 5)")
+    parser.add_argument("--metric", choices=["ns_per_sample", "cycles_per_sample"], default="ns_per_sample")
+    parser.add_argument("--all", action="store_true", help="print every case, not just the regressions")
+    args = parser.parse_args()
+
+    baseline_context, baseline = load(args.baseline)
+    current_context, current = load(args.current)
+
+    # comparing across machines or build types mostly measures the machine, say so rather than failing quietly
+    for key in ("cpu", "build"):
+        if baseline_context.get(key) != current_context.get(key):
+            print(f"warning: {key} differs: {baseline_context.get(key)!r} vs {current_context.get(key)!r}", file=sys.stderr)
+
+    regressions = 0
+
+    for name in sorted(baseline.keys() & current.keys()):
+        before = baseline[name][args.metric]
+        after = current[name][args.metric]
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+
+        regressed = change > args.threshold
+        regressions += regressed
+
+        if regressed or args.all:
+            marker = "REGRESSION" if regressed else ("faster" if change < -args.threshold else "")
+            print(f"{name:70} {before:10.3f} -> {after:10.3f} {args.metric} {change:+7.1f}%  {marker}")
+
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:70} missing from {args.current}")
+
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{name:70} new")
+
+    compared = len(baseline.keys() & current.keys())
+    print(f"{compared} cases compared, {regressions} slower than {args.threshold:g}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    This file contains the biquad bank: the coefficients and states of every
+    section of the EQ in flat structure-of-arrays buffers, run as one cascade.
+
+  ==============================================================================
+*/
+
+#include "BiquadBank.h"
+
+template <typename SampleType>
+void BiquadBank<SampleType>::prepare(int maximumNumSections, int numGroups)
+{
+    maxSections = juce::jmax(1, maximumNumSections);
+    const auto numSections = (size_t) maxSections;
+    const auto numStates = numSections * (size_t) juce::jmax(1, numGroups);
+
+    for (auto* coefficient : { &b0, &b1, &b2, &a1, &a2 })
+        coefficient->assign(numSections, Register::expand(SampleType(0)));
+
+    std::fill(b0.begin(), b0.end(), Register::expand(SampleType(1)));   // flat: y = x
+
+    state1.assign(numStates, Register::expand(SampleType(0)));
+    state2.assign(numStates, Register::expand(SampleType(0)));
+    cascade.resize(numSections);
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::reset() noexcept
+{
+    std::fill(state1.begin(), state1.end(), Register::expand(SampleType(0)));
+    std::fill(state2.begin(), state2.end(), Register::expand(SampleType(0)));
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::resetSections(int firstSection, int numSectionsToReset) noexcept
+{
+    jassert(firstSection >= 0 && firstSection + numSectionsToReset <= maxSections);
+
+    for (size_t group = 0; group < state1.size() / (size_t) maxSections; ++group)
+    {
+        const auto first = group * (size_t) maxSections + (size_t) firstSection;
+        std::fill_n(state1.begin() + (std::ptrdiff_t) first, numSectionsToReset, Register::expand(SampleType(0)));
+        std::fill_n(state2.begin() + (std::ptrdiff_t) first, numSectionsToReset, Register::expand(SampleType(0)));
+    }
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::resetSections(int firstSection, int numSectionsToReset, size_t laneMask) noexcept
+{
+    jassert(firstSection >= 0 && firstSection + numSectionsToReset <= maxSections);
+
+    for (size_t group = 0; group < state1.size() / (size_t) maxSections; ++group)
+    {
+        for (int i = 0; i < numSectionsToReset; ++i)
+        {
+            const auto index = group * (size_t) maxSections + (size_t) (firstSection + i);
+            setLanes(state1[index], SampleType(0), laneMask);
+            setLanes(state2[index], SampleType(0), laneMask);
+        }
+    }
+}
+
+template <typename SampleType>
+std::array<SampleType, 5> BiquadBank<SampleType>::normalise(const Coefficients& coefficients) noexcept
+{
+    // same conversion as IIR::Coefficients: round the double design to SampleType first, then divide by a0
+    std::array<SampleType, 6> converted;
+    for (size_t i = 0; i < converted.size(); ++i)
+        converted[i] = static_cast<SampleType>(coefficients[i]);
+
+    const auto a0 = converted[3];
+    const auto a0Inv = ! juce::approximatelyEqual(a0, SampleType(0)) ? SampleType(1) / a0 : SampleType(0);
+
+    return { converted[0] * a0Inv, converted[1] * a0Inv, converted[2] * a0Inv, converted[4] * a0Inv, converted[5] * a0Inv };
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::setLanes(Register& target, SampleType value, size_t laneMask) noexcept
+{
+    for (size_t lane = 0; lane < numLanes; ++lane)
+        if ((laneMask >> lane) & 1)
+            target.set(lane, value);
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::setSection(int section, const Coefficients& coefficients) noexcept
+{
+    jassert(section >= 0 && section < maxSections);
+
+    const auto normalised = normalise(coefficients);
+    const auto index = (size_t) section;
+
+    b0[index] = Register::expand(normalised[0]);
+    b1[index] = Register::expand(normalised[1]);
+    b2[index] = Register::expand(normalised[2]);
+    a1[index] = Register::expand(normalised[3]);
+    a2[index] = Register::expand(normalised[4]);
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::setSection(int section, const Coefficients& coefficients, size_t laneMask) noexcept
+{
+    jassert(section >= 0 && section < maxSections);
+
+    const auto normalised = normalise(coefficients);
+    const auto index = (size_t) section;
+
+    setLanes(b0[index], normalised[0], laneMask);
+    setLanes(b1[index], normalised[1], laneMask);
+    setLanes(b2[index], normalised[2], laneMask);
+    setLanes(a1[index], normalised[3], laneMask);
+    setLanes(a2[index], normalised[4], laneMask);
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::setSectionFlat(int section, size_t laneMask) noexcept
+{
+    setSection(section, { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 }, laneMask);
+}
+
+template <typename SampleType>
+bool BiquadBank<SampleType>::isSilent(int firstSection, int numSectionsToCheck, SampleType threshold) const noexcept
+{
+    jassert(firstSection >= 0 && firstSection + numSectionsToCheck <= maxSections);
+
+    for (size_t group = 0; group < state1.size() / (size_t) maxSections; ++group)
+    {
+        for (int i = 0; i < numSectionsToCheck; ++i)
+        {
+            const auto index = group * (size_t) maxSections + (size_t) (firstSection + i);
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                if (std::abs(state1[index].get(lane)) > threshold || std::abs(state2[index].get(lane)) > threshold)
+                    return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename SampleType>
+void BiquadBank<SampleType>::process(Register* samples, size_t numSamples, size_t group,
+                                     const int* sections, int numSectionsToRun) noexcept
+{
+    if (numSectionsToRun <= 0)
+        return;
+
+    jassert(numSectionsToRun <= maxSections);
+    const auto numInCascade = (size_t) numSectionsToRun;
+    const auto stateOffset = group * (size_t) maxSections;
+
+    for (size_t i = 0; i < numInCascade; ++i)
+    {
+        const auto index = (size_t) sections[i];
+        cascade[i] = { b0[index], b1[index], b2[index], a1[index], a2[index],
+                       state1[stateOffset + index], state2[stateOffset + index] };
+    }
+
+    // sample by sample through the whole cascade: section n + 1 only waits for section n at the same sample, so the
+    // CPU overlaps the sections' feedback loops instead of stalling on one section's recursion for a whole block.
+    // A list longer than the biggest kernel runs in pieces, each over the whole block, which gives the same result
+    if (numInCascade != kernelLength)
+    {
+        kernelLength = numInCascade;
+        kernel = kernels[juce::jmin(maxUnrolledSections, numInCascade)];
+    }
+
+    if (numInCascade <= maxUnrolledSections)
+    {
+        kernel(samples, numSamples, cascade.data());
+    }
+    else
+    {
+        for (size_t first = 0; first < numInCascade; first += maxUnrolledSections)
+        {
+            const auto numInPiece = juce::jmin(maxUnrolledSections, numInCascade - first);
+            kernels[numInPiece](samples, numSamples, cascade.data() + first);
+        }
+    }
+
+    for (size_t i = 0; i < numInCascade; ++i)
+    {
+        const auto index = (size_t) sections[i];
+        state1[stateOffset + index] = cascade[i].state1;
+        state2[stateOffset + index] = cascade[i].state2;
+    }
+}
+
+template <typename SampleType>
+template <size_t... Index>
+void BiquadBank<SampleType>::processCascade(Register* samples, size_t numSamples, Section* sections, std::index_sequence<Index...>) noexcept
+{
+    // the section count is known at compile time, so the fold expression writes the biquads out one after the other,
+    // without a loop or a branch. Each section is seven registers' worth of coefficients and state: with 16 vector
+    // registers (SSE, NEON) only the shortest kernels keep everything in registers, the longer ones, up to 84 at twelve
+    // sections, spill to the stack. That's still a fixed offset from the stack pointer, in L1, with no index to compute
+    Section local[] = { sections[Index]... };
+
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        auto x = samples[n];
+        ((x = processSample(local[Index], x)), ...);
+        samples[n] = x;
+    }
+
+    ((sections[Index].state1 = local[Index].state1, sections[Index].state2 = local[Index].state2), ...);
+}
+
+template <typename SampleType>
+const std::array<typename BiquadBank<SampleType>::CascadeKernel, BiquadBank<SampleType>::maxUnrolledSections + 1> BiquadBank<SampleType>::kernels
+{
+    nullptr,   // process() returns before it would need this one
+    &BiquadBank<SampleType>::processCascade<1>, &BiquadBank<SampleType>::processCascade<2>,
+    &BiquadBank<SampleType>::processCascade<3>, &BiquadBank<SampleType>::processCascade<4>,
+    &BiquadBank<SampleType>::processCascade<5>, &BiquadBank<SampleType>::processCascade<6>,
+    &BiquadBank<SampleType>::processCascade<7>, &BiquadBank<SampleType>::processCascade<8>,
+    &BiquadBank<SampleType>::processCascade<9>, &BiquadBank<SampleType>::processCascade<10>,
+    &BiquadBank<SampleType>::processCascade<11>, &BiquadBank<SampleType>::processCascade<12>
+};
+
+//==============================================================================
+template class BiquadBank<float>;
+template class BiquadBank<double>;
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    This file contains the biquad bank: the coefficients and states of every
+    section of the EQ in flat structure-of-arrays buffers, run as one cascade.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Any number of biquad sections for any number of channels, kept in contiguous structure-of-arrays buffers.
+
+    Each coefficient (b0, b1, b2, a1, a2, already divided by a0) lives in its own array with one entry per section,
+    stored as a SIMDRegister with the value in every lane, and each state (the two transposed direct form II
+    delays) lives in an array with one entry per section and group of numLanes channels. Nothing is allocated per
+    band or per section, so 24 bands of 4 sections for 8 channels come to about 14 kB and stay in L1.
+
+    process() runs a list of sections as one cascade: the listed sections are first gathered into a small
+    contiguous scratch, then every sample goes through all of them before the next sample is read, and the
+    states are written back at the end. The cost is one biquad per listed section and sample, sections that are
+    left out of the list (a band that is off, a cut using fewer sections) cost nothing.
+
+    The per-sample loop is compiled once for every cascade length up to maxUnrolledSections, enough for the whole
+    default chain (two 48 dB/Oct cuts and a bell are nine), with the section count as a template argument, so a
+    12 dB/Oct cut plus a bell is three biquads written out one after the other, with no loop over sections and no
+    branch per section. The kernel is picked from a table only when the length of the list changes, longer
+    cascades (a layout with more stages) run in pieces of maxUnrolledSections. The speedup of the unrolled kernels
+    over a loop over sections was measured on this class alone, in a standalone harness; Benchmarks/Main.cpp
+    times the whole processor and doesn't isolate it.
+
+    Lanes don't have to share coefficients: with a lane mask, setSection() only writes some lanes, which is how
+    the two channels of a stereo pair run different settings (mid/side, left/right) in the same pass.
+
+    The arithmetic per section is exactly that of juce::dsp::IIR::Filter, so the output matches a chain of
+    IIR::Filter<SIMDRegister> objects bit for bit.
+*/
+template <typename SampleType>
+class BiquadBank
+{
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    using Coefficients = std::array<double, 6>;   // b0, b1, b2, a0, a1, a2, as the designer produces them (BiquadCoefficients)
+
+    static constexpr size_t numLanes = Register::SIMDNumElements;
+    static constexpr size_t maxUnrolledSections = 12;   // the longest cascade with a kernel of its own
+
+    void prepare(int maximumNumSections, int numGroups);   // allocates everything, every section starts out flat
+    void reset() noexcept;
+    void resetSections(int firstSection, int numSectionsToReset) noexcept;   // clears these sections' states in every group
+    void resetSections(int firstSection, int numSectionsToReset, size_t laneMask) noexcept;   // only in the lanes set in laneMask
+
+    // audio thread, no allocation: every lane, or only the lanes set in laneMask, run these coefficients
+    void setSection(int section, const Coefficients& coefficients) noexcept;
+    void setSection(int section, const Coefficients& coefficients, size_t laneMask) noexcept;
+    void setSectionFlat(int section, size_t laneMask) noexcept;   // y = x in these lanes
+
+    // runs the listed sections, in list order, over one group's interleaved samples in place
+    void process(Register* samples, size_t numSamples, size_t group, const int* sections, int numSectionsToRun) noexcept;
+
+    // true when every group's state of these sections is within threshold of zero, so feeding them silence gives silence
+    bool isSilent(int firstSection, int numSectionsToCheck, SampleType threshold) const noexcept;
+
+    int getMaximumNumSections() const noexcept   { return maxSections; }
+
+private:
+    // the sections of the current process() call, gathered next to each other
+    struct Section
+    {
+        Register b0, b1, b2, a1, a2, state1, state2;
+    };
+
+    using CascadeKernel = void (*)(Register*, size_t, Section*) noexcept;
+    static const std::array<CascadeKernel, maxUnrolledSections + 1> kernels;   // indexed by the number of sections
+
+    template <size_t NumSections>
+    static void processCascade(Register* samples, size_t numSamples, Section* sections) noexcept
+    {
+        processCascade(samples, numSamples, sections, std::make_index_sequence<NumSections>());
+    }
+
+    template <size_t... Index>
+    static void processCascade(Register* samples, size_t numSamples, Section* sections, std::index_sequence<Index...>) noexcept;
+
+    static Register processSample(Section& section, Register x) noexcept
+    {
+        const auto y = (x * section.b0) + section.state1;
+        section.state1 = (x * section.b1) - (y * section.a1) + section.state2;
+        section.state2 = (x * section.b2) - (y * section.a2);
+        return y;
+    }
+
+    static std::array<SampleType, 5> normalise(const Coefficients& coefficients) noexcept;
+    static void setLanes(Register& target, SampleType value, size_t laneMask) noexcept;
+
+    int maxSections = 0;
+
+    // one entry per section
+    std::vector<Register> b0, b1, b2, a1, a2;
+
+    // one entry per group and section, group after group
+    std::vector<Register> state1, state2;
+
+    std::vector<Section> cascade;
+
+    // the kernel for the last list length, so slopes and bands that stay put never go back to the table
+    size_t kernelLength = 0;
+    CascadeKernel kernel = nullptr;
+};
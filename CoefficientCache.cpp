@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    This file contains the precomputed coefficient tables the designer can use
+    instead of calling the trig heavy filter design functions.
+
+  ==============================================================================
+*/
+
+#include "CoefficientCache.h"
+
+//==============================================================================
+static juce::CriticalSection cacheRegistryLock;
+static std::map<double, std::weak_ptr<const CoefficientCache>> cacheRegistry;   // only holds caches some instance is still using
+
+std::shared_ptr<const CoefficientCache> CoefficientCache::getFor(double sampleRate, size_t memoryLimitBytes)
+{
+    const juce::ScopedLock sl(cacheRegistryLock);
+
+    if (auto existing = cacheRegistry[sampleRate].lock())
+        return existing;
+
+    auto cache = std::make_shared<const CoefficientCache>(sampleRate, memoryLimitBytes);
+    cacheRegistry[sampleRate] = cache;
+    return cache;
+}
+
+size_t CoefficientCache::getTotalMemoryUsageBytes()
+{
+    const juce::ScopedLock sl(cacheRegistryLock);
+
+    size_t total = 0;
+    for (auto& entry : cacheRegistry)
+        if (auto cache = entry.second.lock())
+            total += cache->getMemoryUsageBytes();
+
+    return total;
+}
+
+//==============================================================================
+CoefficientCache::CoefficientCache(double rate, size_t memoryLimitBytes)
+    : sampleRate(rate)
+{
+    using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<double>;
+
+    auto storeSection = [](std::vector<float>& table, size_t offset, const BiquadCoefficients& coefficients)
+    {
+        const auto a0Inverse = 1.0 / coefficients[3];
+        auto* entry = table.data() + offset;
+        entry[0] = static_cast<float>(coefficients[0] * a0Inverse);
+        entry[1] = static_cast<float>(coefficients[1] * a0Inverse);
+        entry[2] = static_cast<float>(coefficients[2] * a0Inverse);
+        entry[3] = static_cast<float>(coefficients[4] * a0Inverse);
+        entry[4] = static_cast<float>(coefficients[5] * a0Inverse);
+    };
+
+    const auto bytesPerFrequency = sizeof(float) * (size_t) (2 * numCutQs * coefficientsPerSection + 2);
+    numFrequencies = (int) juce::jlimit((size_t) 256, (size_t) 65536, memoryLimitBytes / bytesPerFrequency);
+
+    highPassTable.resize((size_t) (numFrequencies * numCutQs * coefficientsPerSection));
+    lowPassTable.resize(highPassTable.size());
+    peakTrigTable.resize((size_t) numFrequencies * 2);
+
+    // the parameter range goes up to 20 kHz, which is past Nyquist at low sample rates, so the grid stops just below it
+    const auto highestFrequency = juce::jmin(maxFrequency, static_cast<float>(sampleRate * 0.49));
+
+    for (int i = 0; i < numFrequencies; ++i)
+    {
+        const auto normalised = static_cast<float>(i) / static_cast<float>(numFrequencies - 1);
+        const auto frequency = juce::jmin(highestFrequency, minFrequency + (maxFrequency - minFrequency) * std::pow(normalised, 4.f));
+
+        for (int numSections = 1; numSections <= 4; ++numSections)
+        {
+            for (int section = 0; section < numSections; ++section)
+            {
+                const auto q = getButterworthSectionQ(numSections, section);
+                const auto offset = (size_t) ((i * numCutQs + getCutQIndex(numSections, section)) * coefficientsPerSection);
+
+                storeSection(highPassTable, offset, ArrayCoefficients::makeHighPass(sampleRate, frequency, q));
+                storeSection(lowPassTable, offset, ArrayCoefficients::makeLowPass(sampleRate, frequency, q));
+            }
+        }
+
+        const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        peakTrigTable[(size_t) i * 2]     = static_cast<float>(std::sin(omega));
+        peakTrigTable[(size_t) i * 2 + 1] = static_cast<float>(-2.0 * std::cos(omega));
+    }
+
+    for (int i = 0; i < numGains; ++i)
+        peakAmplitudeTable[(size_t) i] = std::sqrt(juce::Decibels::decibelsToGain(minGain + gainStep * static_cast<float>(i)));
+}
+
+size_t CoefficientCache::getMemoryUsageBytes() const noexcept
+{
+    return sizeof(*this) + sizeof(float) * (highPassTable.size() + lowPassTable.size() + peakTrigTable.size());
+}
+
+//==============================================================================
+CoefficientCache::GridPosition CoefficientCache::getGridPosition(float frequency) const noexcept
+{
+    // same mapping as NormalisableRange::convertTo0to1 with a skew of 0.25
+    const auto proportion = juce::jlimit(0.f, 1.f, (frequency - minFrequency) / (maxFrequency - minFrequency));
+    const auto position = std::sqrt(std::sqrt(proportion)) * static_cast<float>(numFrequencies - 1);
+    const auto index = juce::jmin((int) position, numFrequencies - 2);
+
+    return { index, position - static_cast<float>(index) };
+}
+
+ChainCoefficients CoefficientCache::makeChainCoefficients(const ChainSettings& chainSettings) const noexcept
+{
+    ChainCoefficients coefficients;
+    coefficients.peak = makePeakFilter(chainSettings.peakFreq, chainSettings.peakQuality, chainSettings.peakGainInDecibels);
+    coefficients.lowCut = makeLowCut(chainSettings.lowCutFreq, chainSettings.lowCutSlope);
+    coefficients.highCut = makeHighCut(chainSettings.highCutFreq, chainSettings.highCutSlope);
+    return coefficients;
+}
+
+BiquadCoefficients CoefficientCache::makePeakFilter(float frequency, float quality, float gainInDecibels) const noexcept
+{
+    const auto grid = getGridPosition(frequency);
+    const auto* trig = peakTrigTable.data() + grid.index * 2;
+    const auto sinOmega = trig[0] + grid.fraction * (trig[2] - trig[0]);
+    const auto c2 = trig[1] + grid.fraction * (trig[3] - trig[1]);
+
+    const auto gainPosition = (juce::jlimit(minGain, maxGain, gainInDecibels) - minGain) / gainStep;
+    const auto gainIndex = juce::jmin((int) gainPosition, numGains - 2);
+    const auto gainFraction = gainPosition - static_cast<float>(gainIndex);
+    const auto amplitude = peakAmplitudeTable[(size_t) gainIndex]
+                         + gainFraction * (peakAmplitudeTable[(size_t) gainIndex + 1] - peakAmplitudeTable[(size_t) gainIndex]);
+
+    // same formula as IIR::ArrayCoefficients::makePeakFilter, minus the trig and the sqrt
+    const auto alpha = sinOmega / (quality * 2.f);
+    const auto alphaTimesA = alpha * amplitude;
+    const auto alphaOverA = alpha / amplitude;
+
+    return { 1.f + alphaTimesA, c2, 1.f - alphaTimesA, 1.f + alphaOverA, c2, 1.f - alphaOverA };
+}
+
+CutCoefficients CoefficientCache::makeLowCut(float frequency, Slope slope) const noexcept
+{
+    return makeCut(highPassTable, frequency, slope);
+}
+
+CutCoefficients CoefficientCache::makeHighCut(float frequency, Slope slope) const noexcept
+{
+    return makeCut(lowPassTable, frequency, slope);
+}
+
+CutCoefficients CoefficientCache::makeCut(const std::vector<float>& table, float frequency, Slope slope) const noexcept
+{
+    const auto grid = getGridPosition(frequency);
+
+    CutCoefficients cut;
+    cut.numSections = slope + 1;
+
+    for (int section = 0; section < cut.numSections; ++section)
+    {
+        const auto offset = (size_t) ((grid.index * numCutQs + getCutQIndex(cut.numSections, section)) * coefficientsPerSection);
+        const auto* lower = table.data() + offset;
+        const auto* upper = lower + numCutQs * coefficientsPerSection;
+
+        float c[coefficientsPerSection];
+        for (int k = 0; k < coefficientsPerSection; ++k)
+            c[k] = lower[k] + grid.fraction * (upper[k] - lower[k]);
+
+        cut.sections[(size_t) section] = { c[0], c[1], c[2], 1.f, c[3], c[4] };
+    }
+
+    return cut;
+}
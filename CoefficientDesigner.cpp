@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    This file contains the background coefficient designer and the mailbox it
+    uses to hand finished coefficient sets over to the audio thread.
+
+  ==============================================================================
+*/
+
+#include "CoefficientDesigner.h"
+#include "PluginProcessor.h"
+#include "CoefficientCache.h"
+
+//==============================================================================
+void DesignedCoefficients::ChannelSet::assign(const ChainCoefficients& coefficients)
+{
+    peak = coefficients.peak;
+    lowCut = coefficients.lowCut.sections;
+    highCut = coefficients.highCut.sections;
+
+    numLowCutSections = coefficients.lowCut.numSections;
+    numHighCutSections = coefficients.highCut.numSections;
+
+    lowCutActive = coefficients.lowCutActive;
+    peakActive = coefficients.peakActive;
+    highCutActive = coefficients.highCutActive;
+}
+
+//==============================================================================
+CoefficientDesigner::CoefficientDesigner(juce::AudioProcessorValueTreeState& apvtsToUse)
+    : apvts(apvtsToUse)
+{
+}
+
+CoefficientDesigner::~CoefficientDesigner()
+{
+    release();
+}
+
+void CoefficientDesigner::prepare(double newSampleRate, bool usingDoublePrecision)
+{
+    release();   // the designer thread must not be writing while we reset the mailbox below
+
+    sampleRate = newSampleRate;
+    const auto useCache = cacheEnabled && ! usingDoublePrecision;
+    auto newCache = useCache ? CoefficientCache::getFor(sampleRate) : nullptr;
+    designCache.store(newCache.get(), std::memory_order_release);
+    std::atomic_store(&cache, std::move(newCache));   // the editor may be reading the memory usage
+    mailbox.reset();
+
+    for (size_t set = 0; set < designedVersions.size(); ++set)
+        designedVersions[set] = requestedVersions[set].load(std::memory_order_acquire);
+
+    setIsStale.fill(true);   // new rate, or a new cache
+    design({});  // first set is designed right here, so the chains are valid before the first processBlock
+
+    designThread->addTimeSliceClient(this);
+    isRunning = true;
+}
+
+size_t CoefficientDesigner::getCacheMemoryUsageBytes() const noexcept
+{
+    auto currentCache = std::atomic_load(&cache);
+    return currentCache != nullptr ? currentCache->getMemoryUsageBytes() : 0;
+}
+
+void CoefficientDesigner::release()
+{
+    if (isRunning)
+    {
+        designThread->removeTimeSliceClient(this);   // waits for a useTimeSlice call that is currently in progress
+        isRunning = false;
+    }
+}
+
+int CoefficientDesigner::useTimeSlice()
+{
+    std::array<bool, DesignedCoefficients::maxChannelSets> changedSets{};
+    auto anyChanged = false;
+
+    for (size_t set = 0; set < designedVersions.size(); ++set)
+    {
+        const auto version = requestedVersions[set].load(std::memory_order_acquire);
+        changedSets[set] = version != designedVersions[set];
+        designedVersions[set] = version;
+        anyChanged = anyChanged || changedSets[set];
+    }
+
+    if (! anyChanged)
+        return idleIntervalMs;
+
+    design(changedSets);
+    return activeIntervalMs;
+}
+
+ChainCoefficients CoefficientDesigner::makeChainCoefficients(const ChainSettings& chainSettings) const noexcept
+{
+    // the audio thread designs through here while smoothing, and std::atomic_load on a shared_ptr takes a lock in
+    // libstdc++, so this reads the plain pointer published next to it; cache keeps the tables alive until the next prepare()
+    const auto* currentCache = designCache.load(std::memory_order_acquire);
+    auto coefficients = currentCache != nullptr ? currentCache->makeChainCoefficients(chainSettings)
+                                                : ::makeChainCoefficients(chainSettings, sampleRate);
+    setActiveBands(coefficients, chainSettings);
+    return coefficients;
+}
+
+void CoefficientDesigner::design(const std::array<bool, DesignedCoefficients::maxChannelSets>& changedSets)
+{
+    const auto stereoMode = getStereoMode(apvts);
+    const auto numSets = stereoMode == stereoLinked ? 1 : DesignedCoefficients::maxChannelSets;
+
+    auto& slot = mailbox.getWriteSlot();
+    auto tail = 0.0;
+
+    for (int set = 0; set < DesignedCoefficients::maxChannelSets; ++set)
+    {
+        const auto index = (size_t) set;
+        setIsStale[index] = setIsStale[index] || changedSets[index];
+
+        if (set >= numSets)
+            continue;   // not in use, designed once the stereo mode asks for it
+
+        // only the sets whose parameters moved are designed again, the others are copied from the last design
+        if (setIsStale[index])
+        {
+            const auto coefficients = makeChainCoefficients(getChainSettings(apvts, set));
+            designedSets[index].assign(coefficients);
+            tailLengthSamples[index] = getTailLengthSamples(coefficients);
+            setIsStale[index] = false;
+        }
+
+        slot.sets[index] = designedSets[index];
+        tail = juce::jmax(tail, tailLengthSamples[index]);
+    }
+
+    slot.numSets = numSets;
+    slot.stereoMode = stereoMode;
+    tailLengthSeconds.store(tail / sampleRate, std::memory_order_relaxed);
+    mailbox.publish();
+}
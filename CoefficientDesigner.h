@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    This file contains the background coefficient designer and the mailbox it
+    uses to hand finished coefficient sets over to the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class CoefficientCache;
+struct ChainSettings;
+struct ChainCoefficients;
+
+//==============================================================================
+/**
+    Wait-free single producer / single consumer mailbox (a triple buffer).
+
+    The producer always owns one slot to write into, the consumer always owns the slot it is
+    currently using, and the third slot sits in the middle waiting to be picked up. Handing a
+    slot over is a single atomic exchange on either side, so neither thread can ever block the other.
+*/
+template <typename SlotType>
+class TripleBufferMailbox
+{
+public:
+    SlotType& getWriteSlot() noexcept             { return slots[(size_t) writeIndex]; }   // producer only
+
+    void publish() noexcept                       // producer only, hands the write slot to the consumer
+    {
+        writeIndex = middle.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    const SlotType* pullLatest() noexcept         // consumer only, returns nullptr when nothing new was published
+    {
+        if ((middle.load(std::memory_order_relaxed) & newDataFlag) == 0)
+            return nullptr;
+
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return &slots[(size_t) readIndex];
+    }
+
+    void reset() noexcept                         // only while neither side is running
+    {
+        writeIndex = 0;
+        middle = 1;
+        readIndex = 2;
+    }
+
+private:
+    static constexpr int indexMask = 3, newDataFlag = 4;
+
+    std::array<SlotType, 3> slots;
+    int writeIndex{ 0 };
+    std::atomic<int> middle{ 1 };
+    int readIndex{ 2 };
+};
+
+//==============================================================================
+/**
+    One complete set of coefficients for the chain, as plain double precision arrays.
+    The chains copy them into their BiquadBank (rounding to float for the float chain), which never allocates.
+
+    In the stereo-linked mode only sets[0] is used and both channels run it, in mid/side and left/right
+    sets[0] is for mid (or left) and sets[1] for side (or right).
+*/
+struct DesignedCoefficients
+{
+    using Section = std::array<double, 6>;   // a BiquadCoefficients: b0, b1, b2, a0, a1, a2
+
+    static constexpr int maxChannelSets = 2;
+
+    struct ChannelSet
+    {
+        void assign(const ChainCoefficients& coefficients);   // plain copies, never allocates
+
+        Section peak{ 1, 0, 0, 1, 0, 0 };
+        std::array<Section, 4> lowCut{}, highCut{};
+        int numLowCutSections{ 1 }, numHighCutSections{ 1 };
+        bool lowCutActive{ true }, peakActive{ true }, highCutActive{ true };
+    };
+
+    std::array<ChannelSet, maxChannelSets> sets;
+    int numSets{ 1 };
+    int stereoMode{ 0 };   // the StereoMode these sets were designed for
+};
+
+//==============================================================================
+/**
+    Turns ChainSettings snapshots into DesignedCoefficients on a shared background thread.
+
+    parametersChanged() may be called from any thread, including the audio thread, it only bumps an atomic
+    version per channel set. The designer thread notices the new version, designs the channel sets whose
+    parameters moved (a side-only change leaves the mid set alone), publishes the whole thing, and the audio
+    thread picks it up with pullLatest(). If a new set isn't ready yet, pullLatest() returns nullptr and the
+    chains simply keep running on the previous coefficients, so the callback never waits for the designer.
+*/
+class CoefficientDesigner  : private juce::TimeSliceClient
+{
+public:
+    explicit CoefficientDesigner(juce::AudioProcessorValueTreeState& apvts);
+    ~CoefficientDesigner() override;
+
+    // designs the first set synchronously and starts background designing, the cache is skipped when
+    // processing in double precision, its float tables would throw away the extra precision
+    void prepare(double sampleRate, bool usingDoublePrecision = false);
+    void release();                       // stops background designing, e.g. from releaseResources
+
+    static constexpr int allChannelSets = -1;
+
+    void parametersChanged(int channelSet = allChannelSets) noexcept   // any thread
+    {
+        for (int set = 0; set < DesignedCoefficients::maxChannelSets; ++set)
+            if (channelSet == allChannelSets || channelSet == set)
+                requestedVersions[(size_t) set].fetch_add(1, std::memory_order_release);
+    }
+
+    // designs from the shared CoefficientCache tables instead of the exact design functions, takes effect on the next prepare()
+    void setCacheEnabled(bool shouldUseCache) noexcept   { cacheEnabled = shouldUseCache; }
+    bool isCacheEnabled() const noexcept                 { return cacheEnabled; }
+    size_t getCacheMemoryUsageBytes() const noexcept;   // 0 while no cache is in use
+
+    const DesignedCoefficients* pullLatest() noexcept { return mailbox.pullLatest(); }   // audio thread only
+    double getTailLengthSeconds() const noexcept     { return tailLengthSeconds.load(std::memory_order_relaxed); }   // of the last designed set, any thread
+
+    // designs with the cache when there is one, otherwise with the exact design functions, safe on any thread between prepare() calls
+    ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings) const noexcept;
+
+private:
+    int useTimeSlice() override;
+    void design(const std::array<bool, DesignedCoefficients::maxChannelSets>& changedSets);
+
+    struct DesignThread  : juce::TimeSliceThread   // one thread shared by every instance in the process
+    {
+        DesignThread() : juce::TimeSliceThread("EQ Coefficient Designer") { startThread(); }
+        ~DesignThread() override { stopThread(1000); }
+    };
+
+    static constexpr int activeIntervalMs = 1, idleIntervalMs = 5;   // poll faster while automation is moving
+
+    juce::AudioProcessorValueTreeState& apvts;
+    juce::SharedResourcePointer<DesignThread> designThread;
+    TripleBufferMailbox<DesignedCoefficients> mailbox;
+
+    double sampleRate{ 44100.0 };
+    std::atomic<bool> cacheEnabled{ false };   // off by default, the tables interpolate in float and would change the default sound
+    std::shared_ptr<const CoefficientCache> cache;   // shared with every other instance running at the same sample rate
+    std::atomic<const CoefficientCache*> designCache{ nullptr };   // the same tables, for makeChainCoefficients, which must not lock
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+    std::array<std::atomic<juce::uint32>, DesignedCoefficients::maxChannelSets> requestedVersions{};
+
+    // designer thread only: the last design of each channel set, a set that isn't in use goes stale when its parameters move
+    std::array<juce::uint32, DesignedCoefficients::maxChannelSets> designedVersions{};
+    std::array<DesignedCoefficients::ChannelSet, DesignedCoefficients::maxChannelSets> designedSets;
+    std::array<double, DesignedCoefficients::maxChannelSets> tailLengthSamples{};
+    std::array<bool, DesignedCoefficients::maxChannelSets> setIsStale{};
+    bool isRunning{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoefficientDesigner)
+};
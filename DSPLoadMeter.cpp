@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    This file contains the per-instance DSP load meter: stage timings taken in
+    processBlock, turned into rolling statistics off the audio thread.
+
+  ==============================================================================
+*/
+
+#include "DSPLoadMeter.h"
+
+static constexpr int updateIntervalMs = 250, updatesPerLogLine = 4;
+
+//==============================================================================
+// one stream per log file for the whole process: with EQ_DSP_LOAD_LOG set, every instance of a large session
+// logs into the same file, and separate streams would each write at their own idea of the end of the file
+struct DSPLoadMeter::SharedLog
+{
+    bool open(const juce::File& file)
+    {
+        const juce::ScopedLock sl(lock);
+        auto& stream = streams[file.getFullPathName()];
+
+        if (stream == nullptr)
+        {
+            stream = std::make_unique<juce::FileOutputStream>(file);   // appends to an existing log
+
+            if (stream->failedToOpen())
+                stream.reset();
+        }
+
+        return stream != nullptr;
+    }
+
+    void writeLine(const juce::File& file, const juce::String& line)
+    {
+        const juce::ScopedLock sl(lock);   // message thread only, so this never holds up audio
+
+        const auto found = streams.find(file.getFullPathName());
+        if (found == streams.end() || found->second == nullptr)
+            return;
+
+        found->second->writeText(line + "\n", false, false, nullptr);
+        found->second->flush();
+    }
+
+    juce::CriticalSection lock;
+    std::map<juce::String, std::unique_ptr<juce::FileOutputStream>> streams;   // closed when the last meter goes away
+};
+
+DSPLoadMeter::DSPLoadMeter()
+{
+    fifoRecords.resize((size_t) fifo.getTotalSize());
+    history.resize((size_t) historySize);
+    sortScratch.resize((size_t) historySize);
+}
+
+DSPLoadMeter::~DSPLoadMeter()
+{
+    stopTimer();
+}
+
+void DSPLoadMeter::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled == isEnabled())
+        return;
+
+    enabled.store(shouldBeEnabled, std::memory_order_relaxed);
+
+    if (shouldBeEnabled)
+    {
+        historyCount = historyWritePosition = 0;   // stale figures from the last time would only confuse
+        startTimer(updateIntervalMs);
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+void DSPLoadMeter::setLogFile(const juce::File& file)
+{
+    logFile = juce::File();
+
+    if (file == juce::File())
+        return;
+
+    if (sharedLog == nullptr)
+        sharedLog = std::make_unique<juce::SharedResourcePointer<SharedLog>>();
+
+    if ((*sharedLog)->open(file))
+        logFile = file;
+}
+
+void DSPLoadMeter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+}
+
+void DSPLoadMeter::pushBlock(const BlockTimings& timings, int numSamples) noexcept
+{
+    const auto scope = fifo.write(1);
+
+    if (scope.blockSize1 == 0)
+        return;   // nobody drained the FIFO for a while (no editor timer running), dropping a block is fine
+
+    auto& record = fifoRecords[(size_t) scope.startIndex1];
+
+    for (size_t stage = 0; stage < (size_t) numStages; ++stage)
+        record.microseconds[stage] = static_cast<float>((double) timings.ticks[stage] * microsecondsPerTick);
+
+    record.blockMicroseconds = static_cast<float>(numSamples * 1.0e6 / sampleRate);
+}
+
+//==============================================================================
+void DSPLoadMeter::timerCallback()
+{
+    const auto scope = fifo.read(fifo.getNumReady());
+
+    auto append = [this](int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            history[(size_t) historyWritePosition] = fifoRecords[(size_t) i];
+            historyWritePosition = (historyWritePosition + 1) % historySize;
+            historyCount = juce::jmin(historyCount + 1, historySize);
+        }
+    };
+
+    append(scope.startIndex1, scope.blockSize1);
+    append(scope.startIndex2, scope.blockSize2);
+
+    updateSnapshot();
+
+    if (logFile != juce::File() && ++ticksSinceLogLine >= updatesPerLogLine)
+    {
+        ticksSinceLogLine = 0;
+        writeLogLine();
+    }
+}
+
+void DSPLoadMeter::updateSnapshot()
+{
+    snapshot.numBlocks = historyCount;
+
+    if (historyCount == 0)
+        return;
+
+    const auto count = (size_t) historyCount;
+    const auto p99Index = juce::jmin(count - 1, (size_t) std::ceil(0.99 * (double) count) - 1);
+
+    auto getStatistics = [&](auto&& getValue)
+    {
+        double sum = 0.0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            sortScratch[i] = getValue(history[i]);
+            sum += sortScratch[i];
+        }
+
+        std::nth_element(sortScratch.begin(), sortScratch.begin() + (std::ptrdiff_t) p99Index, sortScratch.begin() + (std::ptrdiff_t) count);
+        const auto p99 = (double) sortScratch[p99Index];
+        const auto minimum = (double) *std::min_element(sortScratch.begin(), sortScratch.begin() + (std::ptrdiff_t) count);
+
+        return Statistics{ minimum, sum / (double) count, p99 };
+    };
+
+    for (size_t stage = 0; stage < (size_t) numStages; ++stage)
+        snapshot.stages[stage] = getStatistics([stage](const Record& record) { return record.microseconds[stage]; });
+
+    const auto load = getStatistics([](const Record& record) { return record.microseconds[total] / juce::jmax(record.blockMicroseconds, 1.0f); });
+    snapshot.minLoad = load.minMicroseconds;
+    snapshot.meanLoad = load.meanMicroseconds;
+    snapshot.p99Load = load.p99Microseconds;
+}
+
+void DSPLoadMeter::writeLogLine()
+{
+    static const char* const stageNames[] = { "params", "design", "lowcut", "peak", "highcut", "total" };
+
+    juce::String line;
+    line << juce::Time::getCurrentTime().toISO8601(true) << " " << logLabel
+         << " blocks=" << snapshot.numBlocks
+         << " load_min=" << juce::String(snapshot.minLoad * 100.0, 2) << "%"
+         << " load_mean=" << juce::String(snapshot.meanLoad * 100.0, 2) << "%"
+         << " load_p99=" << juce::String(snapshot.p99Load * 100.0, 2) << "%";
+
+    // microseconds per block, min/mean/p99
+    for (size_t stage = 0; stage < (size_t) numStages; ++stage)
+    {
+        const auto& statistics = snapshot.stages[stage];
+        line << " " << stageNames[stage] << "=" << juce::String(statistics.minMicroseconds, 1)
+             << "/" << juce::String(statistics.meanMicroseconds, 1) << "/" << juce::String(statistics.p99Microseconds, 1);
+    }
+
+    (*sharedLog)->writeLine(logFile, line);
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    This file contains the per-instance DSP load meter: stage timings taken in
+    processBlock, turned into rolling statistics off the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Times the stages of every processBlock and keeps rolling min / mean / p99 figures per instance.
+
+    The audio thread fills a BlockTimings with high resolution ticks and hands the finished block over
+    with pushBlock(), which is a single write into a wait-free FIFO. A timer on the message thread drains
+    the FIFO into a history of the last historySize blocks, works out the statistics for the editor and,
+    if a log file is set, appends one line per second to it. Every instance in the process writes through the
+    same stream per file, so a whole session logging into one file gets whole lines, one after the other.
+
+    When the meter is disabled, processBlock reads isEnabled() once per block and neither clears nor pushes the
+    timings. The ScopedStageTimers stay in place and each one still costs a test of BlockTimings::enabled, a
+    branch that is predicted right every time, but none of them reads the clock.
+*/
+class DSPLoadMeter  : private juce::Timer
+{
+public:
+    enum Stage
+    {
+        parameterFetch,      // picking up designed sets and reading parameters
+        coefficientDesign,   // pointing the chains at new coefficients, and redesigning while smoothing
+        lowCut,              // these three follow the chain order, SIMDFilterChain times them in one go
+        peak,
+        highCut,
+        total,               // the whole of processBlock
+        numStages
+    };
+
+    struct Statistics
+    {
+        double minMicroseconds = 0.0, meanMicroseconds = 0.0, p99Microseconds = 0.0;
+    };
+
+    struct Snapshot
+    {
+        std::array<Statistics, numStages> stages;
+        double minLoad = 0.0, meanLoad = 0.0, p99Load = 0.0;   // total time as a proportion of the audio time each block covered
+        int numBlocks = 0;                      // how many blocks the figures are based on
+    };
+
+    //==============================================================================
+    struct BlockTimings
+    {
+        bool enabled = false;
+        std::array<juce::int64, numStages> ticks{};
+    };
+
+    // adds the time until it goes out of scope to one stage, does nothing when timing is off for this block
+    struct ScopedStageTimer
+    {
+        ScopedStageTimer(BlockTimings& timings, Stage stageToTime) noexcept
+            : target(timings.enabled ? &timings.ticks[(size_t) stageToTime] : nullptr),
+              start(target != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~ScopedStageTimer() noexcept
+        {
+            if (target != nullptr)
+                *target += juce::Time::getHighResolutionTicks() - start;
+        }
+
+        juce::int64* target;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStageTimer)
+    };
+
+    //==============================================================================
+    DSPLoadMeter();
+    ~DSPLoadMeter() override;
+
+    void setEnabled(bool shouldBeEnabled);   // message thread
+    bool isEnabled() const noexcept          { return enabled.load(std::memory_order_relaxed); }
+
+    void setLogFile(const juce::File& file);   // message thread, an empty File stops logging
+    void setLogLabel(const juce::String& label) { logLabel = label; }   // tells instances apart in a shared log
+
+    void prepare(double sampleRate);
+    void pushBlock(const BlockTimings& timings, int numSamples) noexcept;   // audio thread
+
+    const Snapshot& getSnapshot() const noexcept { return snapshot; }   // message thread, updated a few times per second
+
+    static constexpr int historySize = 1024;
+
+private:
+    void timerCallback() override;
+    void updateSnapshot();
+    void writeLogLine();
+
+    struct Record
+    {
+        std::array<float, numStages> microseconds;
+        float blockMicroseconds;
+    };
+
+    std::atomic<bool> enabled{ false };
+    double sampleRate = 44100.0;
+    double microsecondsPerTick = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+
+    juce::AbstractFifo fifo{ 512 };
+    std::vector<Record> fifoRecords;
+
+    std::vector<Record> history;    // message thread only, a ring of the last historySize blocks
+    int historyWritePosition = 0, historyCount = 0;
+    std::vector<float> sortScratch;
+    Snapshot snapshot;
+
+    struct SharedLog;   // the process-wide log streams, see DSPLoadMeter.cpp
+    std::unique_ptr<juce::SharedResourcePointer<SharedLog>> sharedLog;   // only created once logging is on
+    juce::File logFile;
+    juce::String logLabel;
+    int ticksSinceLogLine = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DSPLoadMeter)
+};
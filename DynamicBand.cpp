@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    This file contains the dynamic mode of the peak band: a band-limited
+    envelope follower that turns the peak's gain down as its band gets loud.
+
+  ==============================================================================
+*/
+
+#include "DynamicBand.h"
+
+DynamicBand::DynamicBand(juce::AudioProcessorValueTreeState& apvts)
+    : enabledParameter(apvts.getRawParameterValue("Peak Dynamic")),
+      sidechainParameter(apvts.getRawParameterValue("Peak Sidechain")),
+      thresholdParameter(apvts.getRawParameterValue("Peak Threshold")),
+      ratioParameter(apvts.getRawParameterValue("Peak Ratio")),
+      attackParameter(apvts.getRawParameterValue("Peak Attack")),
+      releaseParameter(apvts.getRawParameterValue("Peak Release")),
+      frequencyParameter(apvts.getRawParameterValue("Peak Freq")),
+      qualityParameter(apvts.getRawParameterValue("Peak Quality"))
+{
+    jassert(enabledParameter != nullptr && sidechainParameter != nullptr && thresholdParameter != nullptr
+            && ratioParameter != nullptr && attackParameter != nullptr && releaseParameter != nullptr
+            && frequencyParameter != nullptr && qualityParameter != nullptr);
+}
+
+void DynamicBand::prepare(double newSampleRate, double newChainSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    chainSampleRate = newChainSampleRate;
+    reductions.assign((size_t) (maximumBlockSize / updateInterval + 1), 0.0f);
+
+    detectorFrequency = detectorQuality = 0.0f;   // both get designed again for the new rates
+    peakFrequency = peakQuality = -1.0f;
+    reset();
+}
+
+void DynamicBand::reset() noexcept
+{
+    detectorState1 = detectorState2 = 0.0;
+    envelope = 0.0;
+    std::fill(reductions.begin(), reductions.end(), 0.0f);
+    lastReduction.store(0.0f, std::memory_order_relaxed);
+}
+
+void DynamicBand::updateDetector() noexcept
+{
+    const auto frequency = frequencyParameter->load(std::memory_order_relaxed);
+    const auto quality = qualityParameter->load(std::memory_order_relaxed);
+
+    if (frequency == detectorFrequency && quality == detectorQuality)
+        return;
+
+    detectorFrequency = frequency;
+    detectorQuality = quality;
+
+    // constant 0 dB peak gain band-pass, so the threshold reads as the level inside the band
+    const auto c = juce::dsp::IIR::ArrayCoefficients<double>::makeBandPass(sampleRate, juce::jmin((double) frequency, 0.45 * sampleRate), quality);
+    const auto a0Inv = 1.0 / c[3];
+    detector = { c[0] * a0Inv, c[1] * a0Inv, c[2] * a0Inv, c[4] * a0Inv, c[5] * a0Inv };
+}
+
+void DynamicBand::setPeak(float frequency, float quality, float gainInDecibels) noexcept
+{
+    peakGain = gainInDecibels;
+
+    if (frequency == peakFrequency && quality == peakQuality)
+        return;
+
+    peakFrequency = frequency;
+    peakQuality = quality;
+
+    const auto omega = juce::MathConstants<double>::twoPi * juce::jmax((double) frequency, 2.0) / chainSampleRate;
+    alpha = std::sin(omega) / (quality * 2.0);
+    cosineTerm = -2.0 * std::cos(omega);
+}
+
+DynamicBand::Coefficients DynamicBand::makePeakSection(int interval) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(interval, (int) reductions.size()));
+    const auto gainInDecibels = (double) peakGain - reductions[(size_t) juce::jlimit(0, (int) reductions.size() - 1, interval)];
+
+    // A = sqrt(gain) = 10^(dB / 40), then the RBJ peak exactly as makePeakFilter builds it
+    const auto A = std::pow(10.0, gainInDecibels / 40.0);
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+
+    return { 1.0 + alphaTimesA, cosineTerm, 1.0 - alphaTimesA, 1.0 + alphaOverA, cosineTerm, 1.0 - alphaOverA };
+}
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    This file contains the dynamic mode of the peak band: a band-limited
+    envelope follower that turns the peak's gain down as its band gets loud.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Level-dependent gain for the peak band, for de-essing and taming resonances without a multiband compressor.
+
+    Once per block, analyse() runs the detector over the input or the sidechain bus: the channels are mixed to
+    mono, band-passed at the peak's frequency and Q, and followed by a peak envelope with the attack and release
+    parameters. Every updateInterval samples the envelope above the threshold is turned into a gain reduction,
+    (level - threshold) * (1 - 1 / ratio) dB, which is taken off the band's static "Peak Gain".
+
+    The chain then gets a new peak section for every interval from makePeakSection(). Frequency and Q only
+    change when the parameters move, so the sine and cosine are kept and a new gain costs one pow() and a few
+    multiplies, the same formula juce::dsp::IIR::ArrayCoefficients::makePeakFilter uses. The dynamic band costs
+    a static one plus the detector biquad and a section update every interval.
+*/
+class DynamicBand
+{
+public:
+    using Coefficients = std::array<double, 6>;   // a BiquadCoefficients: b0, b1, b2, a0, a1, a2
+
+    static constexpr int updateInterval = 32;   // host samples between gain updates, under a millisecond
+    static constexpr float maxReductionInDecibels = 24.0f;
+
+    explicit DynamicBand(juce::AudioProcessorValueTreeState& apvts);
+
+    // the detector runs at the host rate, the peak sections are designed for the chain's rate (higher when oversampling)
+    void prepare(double sampleRate, double chainSampleRate, int maximumBlockSize);
+    void reset() noexcept;
+
+    bool isEnabled() const noexcept          { return enabledParameter->load(std::memory_order_relaxed) > 0.5f; }
+    bool usesSidechain() const noexcept      { return sidechainParameter->load(std::memory_order_relaxed) > 0.5f; }
+
+    // audio thread, once per block before the chain runs: the gain reduction for every interval of the block
+    template <typename SampleType>
+    void analyse(const juce::AudioBuffer<SampleType>& source, int numChannels, int numSamples) noexcept;
+
+    // audio thread: the band's static settings the reduction is applied to, cheap when nothing changed
+    void setPeak(float frequency, float quality, float gainInDecibels) noexcept;
+
+    // audio thread: the peak section for one interval of the block analyse() last looked at
+    Coefficients makePeakSection(int interval) const noexcept;
+
+    float getGainReductionDecibels() const noexcept   { return lastReduction.load(std::memory_order_relaxed); }   // any thread, for meters
+
+private:
+    void updateDetector() noexcept;
+
+    std::atomic<float>* enabledParameter = nullptr;
+    std::atomic<float>* sidechainParameter = nullptr;
+    std::atomic<float>* thresholdParameter = nullptr;
+    std::atomic<float>* ratioParameter = nullptr;
+    std::atomic<float>* attackParameter = nullptr;
+    std::atomic<float>* releaseParameter = nullptr;
+    std::atomic<float>* frequencyParameter = nullptr;
+    std::atomic<float>* qualityParameter = nullptr;
+
+    double sampleRate = 44100.0, chainSampleRate = 44100.0;
+
+    // detector: band-pass at the peak's frequency and Q (transposed direct form II, normalised), and the envelope
+    float detectorFrequency = 0.0f, detectorQuality = 0.0f;
+    std::array<double, 5> detector{};
+    double detectorState1 = 0.0, detectorState2 = 0.0;
+    double envelope = 0.0;
+
+    std::vector<float> reductions;   // per interval of the current block, in dB
+
+    // the peak at the chain's rate, alpha and -2 cos(w) only change with frequency and Q
+    float peakFrequency = -1.0f, peakQuality = -1.0f, peakGain = 0.0f;
+    double alpha = 0.0, cosineTerm = 0.0;
+
+    std::atomic<float> lastReduction{ 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DynamicBand)
+};
+
+//==============================================================================
+template <typename SampleType>
+void DynamicBand::analyse(const juce::AudioBuffer<SampleType>& source, int numChannels, int numSamples) noexcept
+{
+    updateDetector();
+
+    numChannels = juce::jmin(numChannels, source.getNumChannels());
+    const auto gain = numChannels > 0 ? 1.0 / numChannels : 0.0;
+
+    const auto threshold = (double) thresholdParameter->load(std::memory_order_relaxed);
+    const auto slope = 1.0 - 1.0 / juce::jmax(1.0, (double) ratioParameter->load(std::memory_order_relaxed));
+    const auto attack = std::exp(-1.0 / (0.001 * attackParameter->load(std::memory_order_relaxed) * sampleRate));
+    const auto release = std::exp(-1.0 / (0.001 * releaseParameter->load(std::memory_order_relaxed) * sampleRate));
+
+    const auto b0 = detector[0], b1 = detector[1], b2 = detector[2], a1 = detector[3], a2 = detector[4];
+    auto s1 = detectorState1, s2 = detectorState2, level = envelope;
+    auto reduction = 0.0f;
+
+    for (int start = 0, interval = 0; start < numSamples; start += updateInterval, ++interval)
+    {
+        const auto end = juce::jmin(numSamples, start + updateInterval);
+
+        for (int i = start; i < end; ++i)
+        {
+            auto x = 0.0;
+            for (int channel = 0; channel < numChannels; ++channel)
+                x += (double) source.getReadPointer(channel)[i];
+
+            x *= gain;
+            const auto y = x * b0 + s1;
+            s1 = x * b1 - y * a1 + s2;
+            s2 = x * b2 - y * a2;
+
+            const auto rectified = std::abs(y);
+            const auto coefficient = rectified > level ? attack : release;
+            level = rectified + coefficient * (level - rectified);
+        }
+
+        // one log per interval, the envelope is smooth enough that nothing happens in between
+        const auto over = juce::Decibels::gainToDecibels(level, -120.0) - threshold;
+        reduction = over > 0.0 ? (float) juce::jmin((double) maxReductionInDecibels, over * slope) : 0.0f;
+
+        // a block longer than prepare() promised keeps writing the last interval, the same one makePeakSection() reads for it
+        jassert(juce::isPositiveAndBelow(interval, (int) reductions.size()));
+        reductions[(size_t) juce::jlimit(0, (int) reductions.size() - 1, interval)] = reduction;
+    }
+
+    detectorState1 = s1;
+    detectorState2 = s2;
+    envelope = level < 1.0e-12 ? 0.0 : level;   // keep denormals out of the follower when the input goes quiet
+    lastReduction.store(reduction, std::memory_order_relaxed);
+}
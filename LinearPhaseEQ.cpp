@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    This file contains the linear-phase mode: the chain's magnitude response
+    turned into a symmetric FIR kernel and run with partitioned convolution.
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEQ.h"
+#include "PluginProcessor.h"
+
+LinearPhaseEQ::LinearPhaseEQ(juce::AudioProcessorValueTreeState& apvtsToUse)
+    : apvts(apvtsToUse),
+      enabledParameter(apvts.getRawParameterValue("Linear Phase")),
+      lengthParameter(apvts.getRawParameterValue("Linear Phase Length"))
+{
+    jassert(enabledParameter != nullptr && lengthParameter != nullptr);
+}
+
+LinearPhaseEQ::~LinearPhaseEQ()
+{
+    release();
+}
+
+void LinearPhaseEQ::prepare(double newSampleRate, int maximumBlockSize, int numChannels)
+{
+    release();   // the kernel thread must not be loading into the engines we are about to replace
+
+    sampleRate = newSampleRate;
+    floatScratch.setSize(numChannels, maximumBlockSize);
+    convolutions.clear();
+
+    for (int channel = 0; channel < numChannels; channel += 2)
+    {
+        auto convolution = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::NonUniform{ headSize }, *messageQueue);
+        convolution->prepare({ sampleRate, (juce::uint32) maximumBlockSize, (juce::uint32) juce::jmin(2, numChannels - channel) });
+        convolutions.push_back(std::move(convolution));
+    }
+
+    // the engines start out without a kernel; most instances never use this mode, so the (large) kernel is only
+    // designed and loaded once it is switched on, here when it already is, otherwise by the kernel thread
+    designedVersion = requestedVersion.load(std::memory_order_acquire);
+    hasKernel = false;
+
+    if (isEnabled())
+        design();   // the first kernel is on its way before the first processBlock
+
+    kernelThread->addTimeSliceClient(this);
+    isRunning = true;
+}
+
+void LinearPhaseEQ::release()
+{
+    if (isRunning)
+    {
+        kernelThread->removeTimeSliceClient(this);   // waits for a design that is currently in progress
+        isRunning = false;
+    }
+}
+
+void LinearPhaseEQ::reset()
+{
+    for (auto& convolution : convolutions)
+        convolution->reset();
+}
+
+bool LinearPhaseEQ::waitUntilKernelIsLoaded(int timeoutMilliseconds)
+{
+    if (! isEnabled() || convolutions.empty())
+        return true;
+
+    const auto kernelLength = getKernelLength();
+    const auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMilliseconds;
+
+    auto isLoaded = [&]
+    {
+        for (auto& convolution : convolutions)
+            if (convolution->getCurrentIRSize() != kernelLength)   // the engines start out on a one sample impulse
+                return false;
+
+        return true;
+    };
+
+    // an engine only picks up a new kernel while it processes
+    while (! isLoaded())
+    {
+        if (juce::Time::getMillisecondCounter() > deadline)
+            return false;
+
+        processSilence(floatScratch.getNumSamples());
+        juce::Thread::sleep(1);
+    }
+
+    processSilence(juce::roundToInt(sampleRate * crossfadeSeconds));
+    reset();   // only the new kernel is left, and nothing of the silence is in the state
+    return true;
+}
+
+void LinearPhaseEQ::processSilence(int numSamples)
+{
+    for (int done = 0; done < numSamples; done += floatScratch.getNumSamples())
+    {
+        floatScratch.clear();
+        auto block = juce::dsp::AudioBlock<float>(floatScratch).getSubBlock(0, (size_t) juce::jmin(floatScratch.getNumSamples(), numSamples - done));
+        process(block);
+    }
+}
+
+int LinearPhaseEQ::getLatencySamples() const noexcept
+{
+    const auto engineLatency = convolutions.empty() ? 0 : convolutions.front()->getLatency();   // 0 for the non-uniform engine
+    return getKernelLength() / 2 + engineLatency;
+}
+
+//==============================================================================
+int LinearPhaseEQ::useTimeSlice()
+{
+    if (! isEnabled())
+        return idleIntervalMs;   // nobody listens to the kernel, catch up once the mode is switched on
+
+    const auto version = requestedVersion.load(std::memory_order_acquire);
+    if (version == designedVersion && hasKernel)
+        return idleIntervalMs;
+
+    designedVersion = version;
+    design();
+    return activeIntervalMs;
+}
+
+void LinearPhaseEQ::configure(int order)
+{
+    currentOrder = order;
+    const auto fftSize = 1 << order;
+    const auto numBins = fftSize / 2 + 1;
+
+    fft = std::make_unique<juce::dsp::FFT>(order);
+    fftData.assign((size_t) fftSize * 2, 0.0f);
+    cosines.resize((size_t) numBins);
+    cosines2.resize((size_t) numBins);
+    magnitudes.resize((size_t) numBins);
+
+    for (size_t bin = 0; bin < (size_t) numBins; ++bin)
+    {
+        const auto w = juce::MathConstants<double>::twoPi * (double) bin / fftSize;
+        cosines[bin] = std::cos(w);
+        cosines2[bin] = std::cos(2.0 * w);
+    }
+
+    // whether the inverse transform divides by the size or not, a flat spectrum has to come back as a unit impulse
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+    for (int bin = 0; bin < fftSize; ++bin)
+        fftData[(size_t) bin * 2] = 1.0f;
+
+    fft->performRealOnlyInverseTransform(fftData.data());
+    inverseScale = 1.0f / fftData[0];
+}
+
+void LinearPhaseEQ::design()
+{
+    if (convolutions.empty())
+        return;
+
+    const auto kernelLength = getKernelLength();
+    const auto order = juce::roundToInt(std::log2(kernelLength));
+
+    if (order != currentOrder)
+        configure(order);
+
+    const auto chainSettings = getChainSettings(apvts);
+    auto coefficients = makeChainCoefficients(chainSettings, sampleRate);
+    setActiveBands(coefficients, chainSettings);
+
+    // |H|^2 of a biquad only needs cos(w) and cos(2w):
+    // (b0^2 + b1^2 + b2^2 + 2 (b0 b1 + b1 b2) cos w + 2 b0 b2 cos 2w) / (the same with a0, a1, a2)
+    const auto numBins = magnitudes.size();
+    std::fill(magnitudes.begin(), magnitudes.end(), 1.0);
+
+    auto applySection = [&](const BiquadCoefficients& c)
+    {
+        const auto numerator0 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+        const auto numerator1 = 2.0 * (c[0] * c[1] + c[1] * c[2]);
+        const auto numerator2 = 2.0 * c[0] * c[2];
+        const auto denominator0 = c[3] * c[3] + c[4] * c[4] + c[5] * c[5];
+        const auto denominator1 = 2.0 * (c[3] * c[4] + c[4] * c[5]);
+        const auto denominator2 = 2.0 * c[3] * c[5];
+
+        const auto* cos1 = cosines.data();
+        const auto* cos2 = cosines2.data();
+        auto* squared = magnitudes.data();
+
+        for (size_t bin = 0; bin < numBins; ++bin)
+            squared[bin] *= juce::jmax(0.0, numerator0 + numerator1 * cos1[bin] + numerator2 * cos2[bin])
+                          / (denominator0 + denominator1 * cos1[bin] + denominator2 * cos2[bin]);
+    };
+
+    if (coefficients.lowCutActive)
+        for (int i = 0; i < coefficients.lowCut.numSections; ++i)
+            applySection(coefficients.lowCut.sections[(size_t) i]);
+
+    if (coefficients.peakActive)
+        applySection(coefficients.peak);
+
+    if (coefficients.highCutActive)
+        for (int i = 0; i < coefficients.highCut.numSections; ++i)
+            applySection(coefficients.highCut.sections[(size_t) i]);
+
+    // zero phase spectrum: real magnitudes, mirrored for the negative frequencies, so the impulse comes out real and
+    // symmetric around sample 0
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+
+    for (int bin = 0; bin < kernelLength; ++bin)
+    {
+        const auto mirrored = (size_t) juce::jmin(bin, kernelLength - bin);
+        fftData[(size_t) bin * 2] = (float) std::sqrt(magnitudes[mirrored]);
+    }
+
+    fft->performRealOnlyInverseTransform(fftData.data());
+
+    // rotate the impulse into the middle of the kernel and window it, a Blackman window centred on kernelLength / 2
+    // keeps the kernel exactly symmetric around that sample, which is the latency we report
+    juce::AudioBuffer<float> kernel(1, kernelLength);
+    auto* kernelData = kernel.getWritePointer(0);
+    const auto centre = kernelLength / 2;
+
+    for (int n = 0; n < kernelLength; ++n)
+    {
+        const auto phase = juce::MathConstants<double>::twoPi * n / kernelLength;
+        const auto window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        kernelData[n] = fftData[(size_t) ((n - centre + kernelLength) % kernelLength)] * inverseScale * (float) window;
+    }
+
+    // every channel pair gets its own copy, Convolution takes ownership and crossfades to it on its own
+    for (size_t pair = 0; pair < convolutions.size(); ++pair)
+    {
+        auto copy = kernel;
+
+        convolutions[pair]->loadImpulseResponse(std::move(copy), sampleRate,
+                                                juce::dsp::Convolution::Stereo::no,
+                                                juce::dsp::Convolution::Trim::no,
+                                                juce::dsp::Convolution::Normalise::no);
+    }
+
+    hasKernel = true;
+}
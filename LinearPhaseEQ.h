@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    This file contains the linear-phase mode: the chain's magnitude response
+    turned into a symmetric FIR kernel and run with partitioned convolution.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Linear-phase version of the LowCut -> Peak -> HighCut chain.
+
+    A background thread evaluates the magnitude response of the active bands at every FFT bin, turns it into a
+    zero-phase impulse with an inverse FFT, centres and windows it, and loads the result as the impulse response
+    of juce::dsp::Convolution. The convolution runs non-uniformly partitioned (small partitions for the head,
+    large ones for the tail), so a 64k tap kernel costs a few FFTs per block instead of 64k multiplies per sample,
+    and it crossfades to every new kernel, so parameter changes don't click.
+
+    The kernel is symmetric around its centre, which makes the mode kernelLength / 2 samples late: the processor
+    reports that with setLatencySamples(). Convolution is float only, so a double precision host is converted
+    into a float scratch buffer and back.
+*/
+class LinearPhaseEQ  : private juce::TimeSliceClient
+{
+public:
+    explicit LinearPhaseEQ(juce::AudioProcessorValueTreeState& apvts);
+    ~LinearPhaseEQ() override;
+
+    static constexpr int kernelLengths[] = { 8192, 16384, 32768, 65536 };   // same order as the "Linear Phase Length" choices
+
+    // when the mode is on, designs and loads the first kernel before returning; the background thread designs
+    // whenever the mode is on and the parameters moved, or no kernel for this prepare() has been loaded yet
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+    void release();
+    void reset();
+
+    // offline rendering: Convolution swaps a new kernel in on its message queue thread and crossfades to it, so
+    // when that lands depends on scheduling. This feeds the engines silence until every one of them runs the
+    // current kernel and the crossfade is over, then resets them; false if that took longer than the timeout
+    bool waitUntilKernelIsLoaded(int timeoutMilliseconds);
+
+    void parametersChanged() noexcept     { requestedVersion.fetch_add(1, std::memory_order_release); }   // any thread
+
+    bool isEnabled() const noexcept       { return enabledParameter->load(std::memory_order_relaxed) > 0.5f; }
+    int getKernelLength() const noexcept  { return kernelLengths[juce::jlimit(0, 3, (int) lengthParameter->load(std::memory_order_relaxed))]; }
+    int getLatencySamples() const noexcept;
+
+    template <typename SampleType>
+    void process(juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+private:
+    int useTimeSlice() override;
+    void design();
+    void configure(int order);   // FFT, frequency tables and scaling for one kernel length
+    void processSilence(int numSamples);
+
+    struct KernelThread  : juce::TimeSliceThread   // one thread shared by every instance in the process
+    {
+        KernelThread() : juce::TimeSliceThread("EQ Linear Phase Designer") { startThread(); }
+        ~KernelThread() override { stopThread(1000); }
+    };
+
+    static constexpr int headSize = 256;   // first partition of the non-uniform scheme, keeps the engine itself latency free
+    static constexpr int activeIntervalMs = 5, idleIntervalMs = 50;
+    static constexpr double crossfadeSeconds = 0.1;   // longer than the crossfade juce::dsp::Convolution runs to a new kernel
+
+    juce::AudioProcessorValueTreeState& apvts;
+    std::atomic<float>* enabledParameter = nullptr;
+    std::atomic<float>* lengthParameter = nullptr;
+
+    std::vector<std::unique_ptr<juce::dsp::Convolution>> convolutions;   // one per channel pair, Convolution handles at most stereo
+    juce::AudioBuffer<float> floatScratch;                               // double precision blocks go through here
+    double sampleRate = 44100.0;
+
+    // designer thread only
+    int currentOrder = 0;
+    bool hasKernel = false;      // a kernel for the current engines has been loaded
+    float inverseScale = 1.0f;   // makes the inverse FFT give back exactly the magnitudes we put in
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData;
+    std::vector<double> cosines, cosines2, magnitudes;   // per bin
+
+    std::atomic<juce::uint32> requestedVersion{ 0 };
+    juce::uint32 designedVersion = 0;
+    bool isRunning = false;
+
+    juce::SharedResourcePointer<KernelThread> kernelThread;
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> messageQueue;   // loads kernels for every instance
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LinearPhaseEQ)
+};
+
+//==============================================================================
+template <typename SampleType>
+void LinearPhaseEQ::process(juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    const auto numChannels = juce::jmin(block.getNumChannels(), (size_t) floatScratch.getNumChannels());
+    const auto numSamples = block.getNumSamples();
+
+    auto processPairs = [&](juce::dsp::AudioBlock<float> floatBlock)
+    {
+        for (size_t pair = 0, channel = 0; channel < numChannels; ++pair, channel += 2)
+        {
+            auto pairBlock = floatBlock.getSubsetChannelBlock(channel, juce::jmin((size_t) 2, numChannels - channel));
+            juce::dsp::ProcessContextReplacing<float> context(pairBlock);
+            convolutions[pair]->process(context);
+        }
+    };
+
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        processPairs(block);
+    }
+    else
+    {
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = block.getChannelPointer(channel);
+            auto* destination = floatScratch.getWritePointer((int) channel);
+            for (size_t i = 0; i < numSamples; ++i)
+                destination[i] = static_cast<float>(source[i]);
+        }
+
+        processPairs(juce::dsp::AudioBlock<float>(floatScratch).getSubBlock(0, numSamples));
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = floatScratch.getReadPointer((int) channel);
+            auto* destination = block.getChannelPointer(channel);
+            for (size_t i = 0; i < numSamples; ++i)
+                destination[i] = static_cast<double>(source[i]);
+        }
+    }
+}
@@ -0,0 +1,410 @@
+/*
+  ==============================================================================
+
+    This file contains the entry point of the offline renderer, a console build
+    of the EQ that runs NewProjectAudioProcessor over audio files without a DAW,
+    spreading batches of files over all cores.
+
+    There are no build files for it in this repository (see Tests/Main.cpp):
+    a console app has to compile this file together with the plugin's own
+    sources (PluginProcessor, PluginEditor, CoefficientDesigner, CoefficientCache,
+    SIMDFilterChain, BiquadBank, RealtimeSafetyAudit, DSPLoadMeter,
+    SpectrumAnalyzer, LinearPhaseEQ, DynamicBand) and links juce_audio_formats on
+    top of the plugin modules.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../PluginProcessor.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int defaultBlockSize = 512;
+    constexpr int kernelLoadTimeoutMs = 10000;   // a 64k kernel on a busy machine with every core rendering
+
+    struct RenderOptions
+    {
+        juce::File outputDirectory;            // empty: next to the input file, with an "_eq" suffix
+        juce::String outputExtension;          // empty: same format as the input
+        int blockSize = defaultBlockSize;
+        int bitsPerSample = 24;
+        bool useDoublePrecision = false;
+        bool renderTail = false;               // append getTailLengthSeconds() worth of ringing after the input ends
+    };
+
+    struct RenderStats
+    {
+        double audioSeconds = 0.0;
+        double processingSeconds = 0.0;        // processBlock only
+        double totalSeconds = 0.0;             // including reading and writing
+        bool failed = false;
+    };
+
+    //==============================================================================
+    // "Peak Gain=6" sets one parameter, values go through the parameter's own text parsing,
+    // so choices work by name ("36 db/Oct") or index and bools take on/off, true/false or 1/0
+    void applyParameterAssignment(NewProjectAudioProcessor& processor, const juce::String& assignment)
+    {
+        const auto parameterID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+        const auto valueText = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+
+        auto* parameter = processor.apvts.getParameter(parameterID);
+
+        if (parameter == nullptr || valueText.isEmpty())
+            juce::ConsoleApplication::fail("Can't apply \"" + assignment + "\", use --list-parameters to see the parameter IDs");
+
+        parameter->setValueNotifyingHost(parameter->getValueForText(valueText));
+    }
+
+    // presets are the XML the parameter tree writes out, e.g. saved with apvts.copyState().createXml()
+    void applyPreset(NewProjectAudioProcessor& processor, const juce::File& presetFile)
+    {
+        auto xml = juce::parseXML(presetFile);
+
+        if (xml == nullptr || ! xml->hasTagName(processor.apvts.state.getType()))
+            juce::ConsoleApplication::fail("Can't read preset " + presetFile.getFullPathName());
+
+        processor.apvts.replaceState(juce::ValueTree::fromXml(*xml));
+    }
+
+    void listParameters(NewProjectAudioProcessor& processor)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                std::cout << ranged->paramID << " = " << ranged->getCurrentValueAsText() << std::endl;
+    }
+
+    juce::File getOutputFile(const juce::File& input, const RenderOptions& options)
+    {
+        const auto extension = options.outputExtension.isNotEmpty() ? options.outputExtension : input.getFileExtension();
+
+        if (options.outputDirectory != juce::File())
+            return options.outputDirectory.getChildFile(input.getFileNameWithoutExtension() + extension);
+
+        return input.getParentDirectory().getChildFile(input.getFileNameWithoutExtension() + "_eq" + extension);
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void processBlock(NewProjectAudioProcessor& processor, juce::AudioBuffer<float>& buffer,
+                      juce::AudioBuffer<SampleType>& processingBuffer, juce::MidiBuffer& midi, int numSamples)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::ignoreUnused(processingBuffer);
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+            processor.processBlock(block, midi);
+        }
+        else
+        {
+            // files come in as float, so the double path converts here instead of in a host
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    processingBuffer.setSample(channel, i, static_cast<double>(buffer.getSample(channel, i)));
+
+            juce::AudioBuffer<double> block(processingBuffer.getArrayOfWritePointers(), processingBuffer.getNumChannels(), numSamples);
+            processor.processBlock(block, midi);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    buffer.setSample(channel, i, static_cast<float>(processingBuffer.getSample(channel, i)));
+        }
+    }
+
+    // streams the file through the processor one block at a time, so memory use doesn't depend on the file length;
+    // the output lines up with the input: the first getLatencySamples() samples the processor puts out are dropped
+    // and as many samples of silence are run through at the end to push the rest of the file out
+    template <typename SampleType>
+    RenderStats renderStream(NewProjectAudioProcessor& processor, juce::AudioFormatReader& reader,
+                             juce::AudioFormatWriter& writer, const RenderOptions& options)
+    {
+        const auto numChannels = (int) reader.numChannels;
+        const auto totalInputSamples = (juce::int64) reader.lengthInSamples;
+        const auto tailSamples = options.renderTail ? (juce::int64) std::ceil(processor.getTailLengthSeconds() * reader.sampleRate) : 0;
+        const auto latencySamples = (juce::int64) juce::jmax(0, processor.getLatencySamples());   // linear phase, oversampling
+        const auto totalSamplesToProcess = totalInputSamples + tailSamples + latencySamples;
+
+        juce::AudioBuffer<float> buffer(numChannels, options.blockSize);
+        juce::AudioBuffer<SampleType> processingBuffer(std::is_same_v<SampleType, float> ? 0 : numChannels, options.blockSize);
+        juce::MidiBuffer midi;
+
+        RenderStats stats;
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        for (juce::int64 position = 0; position < totalSamplesToProcess; position += options.blockSize)
+        {
+            const auto numSamples = (int) juce::jmin((juce::int64) options.blockSize, totalSamplesToProcess - position);
+
+            buffer.clear();   // past the end of the input the tail is rendered from silence
+            if (position < totalInputSamples)
+                reader.read(&buffer, 0, (int) juce::jmin((juce::int64) numSamples, totalInputSamples - position), position, true, true);
+
+            const auto processStart = juce::Time::getMillisecondCounterHiRes();
+            processBlock(processor, buffer, processingBuffer, midi, numSamples);
+            stats.processingSeconds += (juce::Time::getMillisecondCounterHiRes() - processStart) * 0.001;
+
+            // the part of the block that is still the processor's delay is not written
+            const auto numToSkip = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, latencySamples - position);
+
+            if (numToSkip < numSamples && ! writer.writeFromAudioSampleBuffer(buffer, numToSkip, numSamples - numToSkip))
+            {
+                stats.failed = true;
+                break;
+            }
+        }
+
+        stats.audioSeconds = (double) (totalInputSamples + tailSamples) / reader.sampleRate;
+        stats.totalSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+        return stats;
+    }
+
+    juce::Result renderFile(NewProjectAudioProcessor& processor, juce::AudioFormatManager& formatManager,
+                            const juce::File& input, const RenderOptions& options, RenderStats& stats)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+
+        if (reader == nullptr)
+            return juce::Result::fail("Can't read " + input.getFullPathName());
+
+        const auto output = getOutputFile(input, options);
+        auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+
+        if (format == nullptr)
+            return juce::Result::fail("No writer for " + output.getFileExtension() + " files");
+
+        const auto numChannels = (int) reader->numChannels;
+
+        // any layout the plugin accepts works here too, the processor runs every channel through the same chain;
+        // the sidechain stays disconnected, so the dynamic peak listens to the file itself
+        if (! processor.setMainBusLayout(juce::AudioChannelSet::canonicalChannelSet(numChannels)))
+            return juce::Result::fail("Unsupported channel count in " + input.getFullPathName());
+
+        output.deleteFile();
+        auto stream = output.createOutputStream();
+
+        if (stream == nullptr)
+            return juce::Result::fail("Can't write " + output.getFullPathName());
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader->sampleRate, (unsigned int) numChannels,
+                                                                                options.bitsPerSample, reader->metadataValues, 0));
+
+        if (writer == nullptr)
+            return juce::Result::fail("Can't write " + output.getFullPathName() + " at " + juce::String(options.bitsPerSample) + " bits");
+
+        stream.release();   // the writer owns the stream now
+
+        // a fresh prepare per file, so every file starts from silent filter states at its own sample rate,
+        // that's also what makes the output independent of which worker renders the file and in what order
+        processor.setProcessingPrecision(options.useDoublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                    : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(reader->sampleRate, options.blockSize);
+        processor.prepareToPlay(reader->sampleRate, options.blockSize);
+
+        if (! processor.waitUntilReadyToRender(kernelLoadTimeoutMs))
+        {
+            processor.releaseResources();
+            return juce::Result::fail("The linear-phase kernel for " + input.getFullPathName() + " didn't load in time");
+        }
+
+        stats = options.useDoublePrecision ? renderStream<double>(processor, *reader, *writer, options)
+                                           : renderStream<float>(processor, *reader, *writer, options);
+        processor.releaseResources();
+
+        if (stats.failed)
+            return juce::Result::fail("Writing " + output.getFullPathName() + " failed");
+
+        return juce::Result::ok();
+    }
+
+    juce::String formatRealtime(double audioSeconds, double seconds)
+    {
+        return juce::String(audioSeconds / juce::jmax(seconds, 1.0e-9), 1) + "x realtime";
+    }
+
+    //==============================================================================
+    /**
+        One render thread with its own processor. Workers take the next file off a shared queue as soon
+        as they're free, so a few long files don't leave the other cores idle at the end of a batch.
+        Memory is bounded by the number of workers: each one only holds a single block of audio plus the
+        reader and writer buffers of the file it's working on.
+    */
+    class RenderWorker  : public juce::Thread
+    {
+    public:
+        RenderWorker(int workerIndex, NewProjectAudioProcessor& settings, const juce::Array<juce::File>& filesToRender,
+                     std::atomic<int>& nextFileIndex, const RenderOptions& renderOptions, juce::CriticalSection& outputLock)
+            : juce::Thread("EQ Render Worker " + juce::String(workerIndex)),
+              index(workerIndex), files(filesToRender), nextFile(nextFileIndex), options(renderOptions), consoleLock(outputLock)
+        {
+            // every worker starts from exactly the same parameter state
+            processor.apvts.replaceState(settings.apvts.copyState());
+            formatManager.registerBasicFormats();
+        }
+
+        void run() override
+        {
+            for (auto fileIndex = nextFile.fetch_add(1); fileIndex < files.size() && ! threadShouldExit(); fileIndex = nextFile.fetch_add(1))
+            {
+                const auto input = files[fileIndex];
+
+                RenderStats stats;
+                const auto result = renderFile(processor, formatManager, input, options, stats);
+
+                const juce::ScopedLock sl(consoleLock);
+
+                if (result.failed())
+                {
+                    std::cerr << result.getErrorMessage() << std::endl;
+                    ++numFailed;
+                    continue;
+                }
+
+                totals.audioSeconds += stats.audioSeconds;
+                totals.processingSeconds += stats.processingSeconds;
+                totals.totalSeconds += stats.totalSeconds;
+                ++numRendered;
+
+                // x realtime for the filters alone and for the whole file including disk and codec work
+                std::cout << "[" << index << "] " << input.getFileName() << " -> " << getOutputFile(input, options).getFullPathName() << ": "
+                          << juce::String(stats.audioSeconds, 2) << " s of audio, "
+                          << formatRealtime(stats.audioSeconds, stats.processingSeconds) << " DSP, "
+                          << formatRealtime(stats.audioSeconds, stats.totalSeconds) << " overall" << std::endl;
+            }
+        }
+
+        int index;
+        int numRendered = 0, numFailed = 0;
+        RenderStats totals;
+
+    private:
+        NewProjectAudioProcessor processor;
+        juce::AudioFormatManager formatManager;   // one per worker, readers and writers are created concurrently
+
+        const juce::Array<juce::File>& files;
+        std::atomic<int>& nextFile;
+        const RenderOptions& options;
+        juce::CriticalSection& consoleLock;
+    };
+
+    //==============================================================================
+    void render(const juce::ArgumentList& args)
+    {
+        NewProjectAudioProcessor settings;   // collects the parameters, each worker copies its state
+        RenderOptions options;
+        juce::Array<juce::File> inputs;
+        auto numWorkers = juce::SystemStats::getNumCpus();
+
+        // options are applied in the order given, so "--preset a.xml --set Peak Gain=3" tweaks the preset
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+
+            auto nextValue = [&]() -> juce::String
+            {
+                if (i + 1 >= args.size())
+                    juce::ConsoleApplication::fail("Missing value after " + arg.text);
+
+                return args[++i].text;
+            };
+
+            if (arg == "--preset|-p")                     applyPreset(settings, juce::File::getCurrentWorkingDirectory().getChildFile(nextValue()));
+            else if (arg == "--set|-s")                   applyParameterAssignment(settings, nextValue());
+            else if (arg == "--output-dir|-o")            options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+            else if (arg == "--format|-f")                options.outputExtension = "." + nextValue().trimCharactersAtStart(".");
+            else if (arg == "--block-size|-b")            options.blockSize = juce::jlimit(16, 65536, nextValue().getIntValue());
+            else if (arg == "--bits")                     options.bitsPerSample = nextValue().getIntValue();
+            else if (arg == "--double")                   options.useDoublePrecision = true;
+            else if (arg == "--tail")                     options.renderTail = true;
+            else if (arg == "--jobs|-j")                  numWorkers = juce::jmax(1, nextValue().getIntValue());
+            else if (arg == "--list-parameters")          { listParameters(settings); return; }
+            else if (arg.isOption())                      juce::ConsoleApplication::fail("Unknown option " + arg.text);
+            else                                          inputs.add(arg.resolveAsFile());
+        }
+
+        if (inputs.isEmpty())
+            juce::ConsoleApplication::fail("No input files, see --help");
+
+        if (options.outputDirectory != juce::File() && ! options.outputDirectory.isDirectory())
+            options.outputDirectory.createDirectory();
+
+        // two workers writing the same file would be a race, so refuse up front
+        juce::StringArray outputPaths;
+        for (auto& input : inputs)
+        {
+            const auto outputPath = getOutputFile(input, options).getFullPathName();
+
+            if (outputPaths.contains(outputPath))
+                juce::ConsoleApplication::fail("More than one input would be written to " + outputPath);
+
+            outputPaths.add(outputPath);
+        }
+
+        numWorkers = juce::jmin(numWorkers, inputs.size());
+
+        std::atomic<int> nextFileIndex{ 0 };
+        juce::CriticalSection consoleLock;
+        std::vector<std::unique_ptr<RenderWorker>> workers;
+
+        for (int i = 0; i < numWorkers; ++i)
+            workers.push_back(std::make_unique<RenderWorker>(i, settings, inputs, nextFileIndex, options, consoleLock));
+
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        for (auto& worker : workers)
+            worker->startThread();
+
+        for (auto& worker : workers)
+            worker->waitForThreadToExit(-1);
+
+        const auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+        // per worker figures show how evenly the queue was spread, the aggregate is what sizes a render farm
+        RenderStats totals;
+        int numFailed = 0;
+
+        for (auto& worker : workers)
+        {
+            std::cout << "worker " << worker->index << ": " << worker->numRendered << " files, "
+                      << juce::String(worker->totals.audioSeconds, 1) << " s of audio, "
+                      << formatRealtime(worker->totals.audioSeconds, worker->totals.processingSeconds) << " DSP, "
+                      << formatRealtime(worker->totals.audioSeconds, worker->totals.totalSeconds) << " overall" << std::endl;
+
+            totals.audioSeconds += worker->totals.audioSeconds;
+            numFailed += worker->numFailed;
+        }
+
+        std::cout << "total: " << inputs.size() - numFailed << " files, " << juce::String(totals.audioSeconds, 1) << " s of audio in "
+                  << juce::String(wallSeconds, 2) << " s on " << numWorkers << " workers, "
+                  << formatRealtime(totals.audioSeconds, wallSeconds) << std::endl;
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail(juce::String(numFailed) + " files failed");
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;   // the processor's parameter tree and designer thread expect the message manager to exist
+
+    juce::ConsoleApplication app;
+
+    app.addHelpCommand("--help|-h", "Usage: EQRender [options] <input files...>\n"
+                                    "  --preset, -p <file>       load parameters from a preset XML\n"
+                                    "  --set, -s \"<id>=<value>\"  set one parameter, e.g. --set \"Peak Gain=-3\"\n"
+                                    "  --output-dir, -o <dir>    write here instead of next to the input (<name>_eq)\n"
+                                    "  --format, -f <ext>        output format by extension (wav, aiff, flac), default same as input\n"
+                                    "  --bits <n>                output bit depth, default 24\n"
+                                    "  --block-size, -b <n>      processing block size, default 512\n"
+                                    "  --double                  process in double precision\n"
+                                    "  --tail                    keep rendering until the filters have rung out\n"
+                                    "  --jobs, -j <n>            render this many files at once, default one per CPU core\n"
+                                    "  --list-parameters         print the parameter IDs and their current values", true);
+
+    app.addDefaultCommand({ "", "[options] <input files...>", "Renders each input file through the EQ", {}, render });
+
+    return app.findAndRunCommand(argc, argv);
+}
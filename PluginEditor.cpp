@@ -45,12 +45,7 @@ void NewProjectAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
    // g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-    g.fillAll(juce::Colours::darkgreen);   // filling with black background
-    auto displayBox = getLocalBounds();
-
-    g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    g.fillAll(juce::Colours::darkgreen);   // filling with black background, the response curve draws itself from its cached image
 }
 
 void NewProjectAudioProcessorEditor::resized()
@@ -77,23 +72,188 @@ void NewProjectAudioProcessorEditor::resized()
 
     //area now represents the drawable area for placing sliders and knobs.
     auto area = getLocalBounds();
+    loadMeterDisplay.setBounds(area.removeFromBottom(20));   // the load readout takes a thin strip at the bottom, the knobs share the rest
+    spectrumDisplay.setBounds(area.removeFromTop(area.getHeight() * 0.3));   // the analyzer sits on top, where the response display was sketched above
+    responseCurve.setBounds(spectrumDisplay.getBounds());   // with the response curve drawn over it
+    int top = area.getY();   // the knobs are laid out below the analyzer
+
     int sliderWidth = area.getWidth() / 5;      // dividing the total width into three equal parts for top three sliders
     int sliderHeight = area.getHeight() * 0.6;   //we allocate 60% of the vertical space for the top row of sliders
 
-    peakFreqSlider.setBounds(0, 0, sliderWidth, sliderHeight);   // first slider goes at the top left corner ( x = 0, y = 0) with the defined width/height
-    peakGainSlider.setBounds(sliderWidth*2, 0, sliderWidth, sliderHeight); // second slider is placed immidiatly to the right of the first one ( x= sliderWidth, y = sliderWidth)
-    peakQualitySlider.setBounds(sliderWidth * 4, 0, sliderWidth, sliderHeight);  
+    peakFreqSlider.setBounds(0, top, sliderWidth, sliderHeight);   // first slider goes at the top left corner ( x = 0, y = top) with the defined width/height
+    peakGainSlider.setBounds(sliderWidth*2, top, sliderWidth, sliderHeight); // second slider is placed immidiatly to the right of the first one ( x= sliderWidth, y = sliderWidth)
+    peakQualitySlider.setBounds(sliderWidth * 4, top, sliderWidth, sliderHeight);  
 
 
     //Bottom knobs
     int knowWidth = area.getWidth() / 2;   //dividing the total width into two halves for the two rotary knobs underneath
     int knowHeight = area.getHeight() * 0.4;  // you assigh 40% of the height to the two bottom knobs
 
-    lowCutSlider.setBounds(0, sliderHeight, knowWidth, knowHeight); // first knob starts at the bottom left (x = 0, y = sliderheight(right below the top slider) 
-    highCutSlider.setBounds(knowWidth, sliderHeight, knowWidth, knowHeight);
+    lowCutSlider.setBounds(0, top + sliderHeight, knowWidth, knowHeight); // first knob starts at the bottom left (x = 0, y = sliderheight(right below the top slider) 
+    highCutSlider.setBounds(knowWidth, top + sliderHeight, knowWidth, knowHeight);
 }
 std::vector<juce::Component*>NewProjectAudioProcessorEditor::getComponets() {
     return{
-        &lowCutSlider, &highCutSlider, &peakFreqSlider, &peakGainSlider, &peakQualitySlider
+        &lowCutSlider, &highCutSlider, &peakFreqSlider, &peakGainSlider, &peakQualitySlider, &spectrumDisplay, &responseCurve, &loadMeterDisplay
+    };
+}
+
+//==============================================================================
+SpectrumDisplay::SpectrumDisplay(SpectrumAnalyzer& analyzerToShow) : analyzer(analyzerToShow) {
+    analyzer.addView();   // the analyzer only does any work while a view like this one is open, a second one costs nothing extra
+    startTimerHz(30);
+}
+
+SpectrumDisplay::~SpectrumDisplay() {
+    analyzer.removeView();
+}
+
+void SpectrumDisplay::timerCallback() {
+    const auto sequence = analyzer.getSequence();
+
+    if (sequence != lastSequence) {
+        lastSequence = sequence;
+        repaint();
+    }
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g) {
+    g.fillAll(juce::Colours::black.withAlpha(0.6f));
+
+    const auto frame = analyzer.acquireLatest();   // pins the frame while we draw it, nothing is copied
+    if (!frame || !frame->hasSpectrum)
+        return;
+
+    // the analyzer hands over paths in a unit square, stretch them over the component
+    auto bounds = getLocalBounds().toFloat();
+    auto transform = juce::AffineTransform::scale(bounds.getWidth(), bounds.getHeight()).translated(bounds.getX(), bounds.getY());
+
+    g.setColour(juce::Colours::lightgrey.withAlpha(0.5f));
+    g.strokePath(frame->average[SpectrumAnalyzer::preEQ], juce::PathStrokeType(1.0f), transform);
+
+    auto postFill = frame->average[SpectrumAnalyzer::postEQ];   // close the post EQ curve along the bottom edge to fill it
+    postFill.lineTo(1.0f, 1.0f);
+    postFill.lineTo(0.0f, 1.0f);
+    postFill.closeSubPath();
+    g.setColour(juce::Colours::lightgreen.withAlpha(0.35f));
+    g.fillPath(postFill, transform);
+
+    g.setColour(juce::Colours::lightgreen);
+    g.strokePath(frame->average[SpectrumAnalyzer::postEQ], juce::PathStrokeType(1.5f), transform);
+    g.setColour(juce::Colours::yellow.withAlpha(0.6f));
+    g.strokePath(frame->peakHold[SpectrumAnalyzer::postEQ], juce::PathStrokeType(1.0f), transform);
+}
+
+//==============================================================================
+ResponseCurveComponent::ResponseCurveComponent(SpectrumAnalyzer& analyzerToShow) : analyzer(analyzerToShow) {
+    analyzer.addView();   // keeps the response coming even if no spectrum display is open
+    addAndMakeVisible(phaseButton);
+    phaseButton.onClick = [this] { needsRendering = true; };   // the phase comes with every frame, it only needs drawing
+
+    startTimerHz(60);
+}
+
+ResponseCurveComponent::~ResponseCurveComponent() {
+    analyzer.removeView();
+}
+
+void ResponseCurveComponent::resized() {
+    phaseButton.setBounds(getLocalBounds().removeFromTop(20).removeFromRight(70));
+    needsRendering = true;
+}
+
+void ResponseCurveComponent::timerCallback() {
+    const auto frame = analyzer.acquireLatest();
+    if (!frame)
+        return;
+
+    if (needsRendering || frame->responseVersion != renderedResponseVersion) {
+        renderImage(*frame);
+        repaint();
+    }
+}
+
+void ResponseCurveComponent::renderImage(const SpectrumAnalyzer::Frame& frame) {
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
+
+    needsRendering = false;
+    renderedResponseVersion = frame.responseVersion;
+
+    cachedImage = juce::Image(juce::Image::ARGB, getWidth(), getHeight(), true);
+    juce::Graphics g(cachedImage);
+
+    // 0 dB line
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.drawHorizontalLine(getHeight() / 2, 0.0f, (float)getWidth());
+
+    auto transform = juce::AffineTransform::scale((float)getWidth(), (float)getHeight());
+
+    if (phaseButton.getToggleState()) {
+        g.setColour(juce::Colours::skyblue.withAlpha(0.7f));
+        g.strokePath(frame.phase, juce::PathStrokeType(1.0f), transform);
+    }
+
+    g.setColour(juce::Colours::white);
+    g.strokePath(frame.magnitude, juce::PathStrokeType(2.0f), transform);
+}
+
+void ResponseCurveComponent::paint(juce::Graphics& g) {
+    g.drawImageAt(cachedImage, 0, 0);   // everything was drawn when the response last changed
+}
+
+//==============================================================================
+LoadMeterDisplay::LoadMeterDisplay(NewProjectAudioProcessor& processorToShow) : processor(processorToShow), meter(processorToShow.getLoadMeter()) {
+    addAndMakeVisible(enableButton);
+    enableButton.setToggleState(meter.isEnabled(), juce::dontSendNotification);   // may already be on, e.g. when logging
+
+    enableButton.onClick = [this] {
+        meter.setEnabled(enableButton.getToggleState());
+        repaint();
     };
+
+    addAndMakeVisible(cacheButton);
+    cacheButton.setToggleState(processor.isCoefficientCacheEnabled(), juce::dontSendNotification);
+    cacheButton.onClick = [this] { processor.setCoefficientCacheEnabled(cacheButton.getToggleState()); };
+
+    startTimerHz(4);
+}
+
+void LoadMeterDisplay::resized() {
+    auto area = getLocalBounds();
+    enableButton.setBounds(area.removeFromLeft(90));
+    cacheButton.setBounds(area.removeFromRight(190).removeFromLeft(100));   // the cache's memory figure goes next to it
+}
+
+void LoadMeterDisplay::paint(juce::Graphics& g) {
+    g.setColour(juce::Colours::white);
+    g.setFont(12.0f);
+
+    // the coefficient tables are shared by every instance at the same rate, this is what this instance's share points at
+    const auto cacheBytes = processor.getCoefficientCacheMemoryUsage();
+    g.drawFittedText(cacheBytes > 0 ? juce::String((int) (cacheBytes / 1024)) + " KB" : juce::String("off"),
+                     getLocalBounds().removeFromRight(90), juce::Justification::centredLeft, 1);
+
+    if (!meter.isEnabled())
+        return;
+
+    const auto& snapshot = meter.getSnapshot();
+    if (snapshot.numBlocks == 0)
+        return;
+
+    // load as min/mean/p99 of the audio time, then every stage as min/mean/p99 in microseconds per block
+    auto stageText = [&](const char* name, DSPLoadMeter::Stage stage) {
+        const auto& statistics = snapshot.stages[(size_t)stage];
+        return juce::String(name) + " " + juce::String(statistics.minMicroseconds, 1) + "/" + juce::String(statistics.meanMicroseconds, 1)
+             + "/" + juce::String(statistics.p99Microseconds, 1);
+    };
+
+    juce::String text;
+    text << "load " << juce::String(snapshot.minLoad * 100.0, 1) << "%/" << juce::String(snapshot.meanLoad * 100.0, 1) << "%/"
+         << juce::String(snapshot.p99Load * 100.0, 1) << "%   "
+         << stageText("params", DSPLoadMeter::parameterFetch) << "  " << stageText("design", DSPLoadMeter::coefficientDesign) << "  "
+         << stageText("low", DSPLoadMeter::lowCut) << "  " << stageText("peak", DSPLoadMeter::peak) << "  "
+         << stageText("high", DSPLoadMeter::highCut) << "  " << stageText("total", DSPLoadMeter::total) << " us";
+
+    g.drawFittedText(text, getLocalBounds().withTrimmedLeft(95).withTrimmedRight(195), juce::Justification::centredLeft, 1);
 }
@@ -165,6 +165,56 @@ struct CustomRotarySlider : juce::Slider {
     }
 };
 
+// pre (grey) and post (filled) EQ spectrum with peak hold, drawn straight from the processor's analysis frames
+struct SpectrumDisplay : juce::Component, private juce::Timer {
+    explicit SpectrumDisplay(SpectrumAnalyzer& analyzerToShow);
+    ~SpectrumDisplay() override;
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    void timerCallback() override;
+
+    SpectrumAnalyzer& analyzer;
+    juce::uint64 lastSequence = 0;
+};
+
+// magnitude (and optionally phase) response of the whole chain from the same frames, rendered into a cached image
+// only when the analyzer computed a new response, so a repaint is one blit
+struct ResponseCurveComponent : juce::Component, private juce::Timer {
+    explicit ResponseCurveComponent(SpectrumAnalyzer& analyzerToShow);
+    ~ResponseCurveComponent() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void renderImage(const SpectrumAnalyzer::Frame& frame);
+
+    SpectrumAnalyzer& analyzer;
+    juce::uint64 renderedResponseVersion = 0;
+    bool needsRendering = true;   // size or phase display changed
+    juce::Image cachedImage;
+    juce::ToggleButton phaseButton{ "Phase" };
+};
+
+// strip along the bottom of the editor: a switch for the processor's DSPLoadMeter and its latest figures
+struct LoadMeterDisplay : juce::Component, private juce::Timer {
+    explicit LoadMeterDisplay(NewProjectAudioProcessor& processorToShow);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void timerCallback() override { repaint(); }   // the meter itself updates a few times per second, no point going faster
+
+    NewProjectAudioProcessor& processor;
+    DSPLoadMeter& meter;
+    juce::ToggleButton enableButton{ "DSP load" };
+    juce::ToggleButton cacheButton{ "Coeff cache" };   // takes effect the next time the host prepares the plugin
+};
+
 //==============================================================================
 /**
 */
@@ -189,6 +239,10 @@ private:
     using AttachmentToParam = APTVS::SliderAttachment;
     AttachmentToParam lowCutSliderAttach, highCutSliderAttach, peakFreqSliderAttach, peakGainSliderAttach, peakQualitySliderAttach;
 
+    SpectrumDisplay spectrumDisplay{ audioProcessor.getAnalyzer() };
+    ResponseCurveComponent responseCurve{ audioProcessor.getAnalyzer() };   // drawn over the spectrum, same bounds
+    LoadMeterDisplay loadMeterDisplay{ audioProcessor };
+
 
     std::vector<juce::Component*>getComponets();
 
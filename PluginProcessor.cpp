@@ -16,16 +16,40 @@ NewProjectAudioProcessor::NewProjectAudioProcessor()
 #if ! JucePlugin_IsMidiEffect
 #if ! JucePlugin_IsSynth
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
+        .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)   // optional key input for the dynamic peak band
 #endif
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
     )
 #endif
 {
+    for (auto* param : getParameters())   // every parameter feeds the filter design, so listen to all of them
+        if (auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.addParameterListener(rangedParam->paramID, this);
+
+    startTimer(setupPollIntervalMs);
+
+    smoothingParameter = apvts.getRawParameterValue("Smoothing");
+    sampleAccurateParameter = apvts.getRawParameterValue("Sample Accurate Automation");
+
+    // EQ_DSP_LOAD_LOG=/some/file.log logs the load figures of every instance once per second, editor open or not
+    const auto loadLogPath = juce::SystemStats::getEnvironmentVariable("EQ_DSP_LOAD_LOG", {});
+
+    if (juce::File::isAbsolutePath(loadLogPath))
+    {
+        loadMeter.setLogLabel("instance@" + juce::String::toHexString((juce::pointer_sized_int) this));
+        loadMeter.setLogFile(juce::File(loadLogPath));
+        loadMeter.setEnabled(true);
+    }
 }
 
 NewProjectAudioProcessor::~NewProjectAudioProcessor()
 {
+    stopTimer();
+
+    for (auto* param : getParameters())
+        if (auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.removeParameterListener(rangedParam->paramID, this);
 }
 
 //==============================================================================
@@ -63,7 +87,10 @@ bool NewProjectAudioProcessor::isMidiEffect() const
 
 double NewProjectAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    if (linearPhaseEQ.isEnabled() && getSampleRate() > 0.0)
+        return linearPhaseEQ.getKernelLength() / getSampleRate();   // the kernel rings (and pre-rings) for its whole length
+
+    return coefficientDesigner.getTailLengthSeconds();   // follows the current cut and peak settings
 }
 
 int NewProjectAudioProcessor::getNumPrograms()
@@ -96,204 +123,213 @@ void NewProjectAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBl
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
-
-    auto chainSettings = getChainSettings(apvts);
-    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality,
-        juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    loadMeter.prepare(sampleRate);
+    linearPhaseEQ.prepare(sampleRate, samplesPerBlock, getMainBusNumInputChannels());
+    prepareOversampled(sampleRate, samplesPerBlock);
+    updateLatency();
+    isPrepared = true;
+}
 
+void NewProjectAudioProcessor::prepareOversampled(double sampleRate, int samplesPerBlock)
+{
+    const auto numChannels = getMainBusNumInputChannels();   // the sidechain only feeds the dynamic band's detector
+    oversamplingOrder = juce::jlimit(0, 3, (int) apvts.getRawParameterValue("Oversampling")->load());
+    oversamplingFilter = (int) apvts.getRawParameterValue("Oversampling Filter")->load();
+    floatOversampler.reset();
+    doubleOversampler.reset();
 
-    if (peakCoefficients)
+    if (oversamplingOrder > 0)
     {
-        auto& peak = rightChain.get<ChainPosition::Peak>();
-        *peak.coefficients = *peakCoefficients;
+        // polyphase IIR halfband filters add little latency, the equiripple FIR ones are linear phase but longer;
+        // integer latency so the host can compensate it exactly
+        auto makeOversampler = [&](auto& oversampler)
+        {
+            using Oversampler = typename std::decay_t<decltype(oversampler)>::element_type;
+            const auto filterType = oversamplingFilter == 0 ? Oversampler::filterHalfBandPolyphaseIIR
+                                                            : Oversampler::filterHalfBandFIREquiripple;
+
+            oversampler = std::make_unique<Oversampler>((size_t) numChannels, (size_t) oversamplingOrder, filterType, oversamplingFilter != 0, true);
+            oversampler->initProcessing((size_t) samplesPerBlock);
+        };
+
+        makeOversampler(floatOversampler);
+        makeOversampler(doubleOversampler);
     }
 
-    if (peakCoefficients)
+    canSplitChannels = numChannels == 2;   // mid/side and left/right need a stereo pair, anything else stays linked
+    const auto chainSampleRate = sampleRate * (1 << oversamplingOrder);
+    const auto chainBlockSize = samplesPerBlock << oversamplingOrder;
+
+    floatChain.prepare(chainSampleRate, chainBlockSize, numChannels);
+    doubleChain.prepare(chainSampleRate, chainBlockSize, numChannels);
+    analyzer.prepare(sampleRate, chainSampleRate);
+    dynamicBand.prepare(sampleRate, chainSampleRate, samplesPerBlock);
+
+    // the designer hands over its first coefficient set synchronously, after that it designs on its own thread
+    coefficientDesigner.prepare(chainSampleRate, isUsingDoublePrecision());
+
     {
-        auto& peak = leftChain.get<ChainPosition::Peak>();
-        *peak.coefficients = *peakCoefficients;
-    }
-   
-   // *leftChain.get<ChainPosition::Peak().coefficients = *peakCoefficients;
-   // *leftChain.get <ChainPosition::Peak().coefficients = *peakCoefficients;
-
-    auto cutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, 
-                                                                                                       sampleRate, 
-                                                                                                      2 * (chainSettings.lowCutSlope + 1));
-    auto& leftLowCut = leftChain.get < ChainPosition::LowCut>();
-    leftLowCut.setBypassed<0>(true);
-    leftLowCut.setBypassed<1>(true);
-    leftLowCut.setBypassed<2>(true);
-    leftLowCut.setBypassed<3>(true);
-
-    switch (chainSettings.lowCutSlope)
-    {
-    case Slope12:
-        
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *cutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *cutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *cutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *cutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *cutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        *leftLowCut.get<3>().coefficients = *cutCoefficients[3];
-        leftLowCut.setBypassed<3>(false);
-
-        break;
+        // everything is allocated by now, what follows is the same code the audio thread runs, so it is audited like processBlock
+        RealtimeSafetyAudit::ScopedRealtimeSection realtimeSection;
+
+        currentDesigned = coefficientDesigner.pullLatest();
+        jassert(currentDesigned != nullptr);
+        applyCoefficients(*currentDesigned);
+        floatChain.skipFades();   // nothing is playing yet, so bands can start in their final state
+        doubleChain.skipFades();
+
+        for (auto& smoother : smoothers)
+            smoother.prepare(chainSampleRate);   // they advance once per chain sample
+
+        resetSmoothers();   // the smoothed sets start out matching the parameters
+        wasSmoothing = false;
+        isIdle = false;
+        wasLinearPhase = linearPhaseEQ.isEnabled();
+        silentInputSamples = 0;
     }
+}
 
+bool NewProjectAudioProcessor::setMainBusLayout(const juce::AudioChannelSet& channels)
+{
+    // start from the current layout, so every bus the constructor declared is still there and only the main pair changes
+    auto layout = getBusesLayout();
+    layout.inputBuses.getReference(0) = channels;
+    layout.outputBuses.getReference(0) = channels;
 
-    auto& rightLowCut = rightChain.get < ChainPosition::LowCut>();
-    rightLowCut.setBypassed<0>(true);
-    rightLowCut.setBypassed<1>(true);
-    rightLowCut.setBypassed<2>(true);
-    rightLowCut.setBypassed<3>(true);
-
-    switch (chainSettings.lowCutSlope)
-    {
-    case Slope12:
-
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *cutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *cutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *cutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *cutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *cutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        *rightLowCut.get<3>().coefficients = *cutCoefficients[3];
-        rightLowCut.setBypassed<3>(false);
-
-        break;
+    for (int bus = 1; bus < layout.inputBuses.size(); ++bus)
+        layout.inputBuses.getReference(bus) = juce::AudioChannelSet::disabled();
+
+    return setBusesLayout(layout);
+}
+
+//==============================================================================
+static constexpr const char* secondChannelSetPrefix = "Ch2 ";   // the IDs of the side / right bands (see bandParameterIDs)
+
+void NewProjectAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    // can be called from any thread (automation comes in on the audio thread), so this only bumps
+    // the designer's version, the actual redesign happens on the designer thread
+    juce::ignoreUnused(parameterID, newValue);
+
+    if (isRestoringState.load(std::memory_order_relaxed))
+        return;   // setStateInformation asks for one design once every parameter is in
+
+    // only the channel set whose band moved is designed again, a new stereo mode needs both
+    const auto channelSet = parameterID == "Stereo Mode" ? CoefficientDesigner::allChannelSets
+                                                         : (parameterID.startsWith(secondChannelSetPrefix) ? 1 : 0);
+
+    coefficientDesigner.parametersChanged(channelSet);
+    analyzer.parametersChanged();   // same for the response curve the editors show
+    linearPhaseEQ.parametersChanged();   // and the linear-phase kernel, which is only designed while that mode is on
+
+    if (parameterID == "Linear Phase" || parameterID == "Linear Phase Length"
+        || parameterID == "Oversampling" || parameterID == "Oversampling Filter")
+        setupMayHaveChanged.store(true, std::memory_order_release);   // the latency changes with the mode, the kernel length and the oversampling
+}
+
+void NewProjectAudioProcessor::applyPendingSetupChange()
+{
+    // message thread: parameterChanged only latches, posting a message from the audio thread could allocate or lock
+    if (! setupMayHaveChanged.exchange(false, std::memory_order_acq_rel))
+        return;
+
+    const auto order = juce::jlimit(0, 3, (int) apvts.getRawParameterValue("Oversampling")->load());
+    const auto filter = (int) apvts.getRawParameterValue("Oversampling Filter")->load();
+    const auto filterMatters = order > 0 || oversamplingOrder > 0;
+
+    if (isPrepared && (order != oversamplingOrder || (filterMatters && filter != oversamplingFilter)))
+    {
+        // a new oversampling setup means new filters and a new chain rate, which is nothing for the audio thread;
+        // only the oversampled part is set up again, the callback is held for that moment and the rest of the
+        // processor (and what the host prepared it with) stays as it is
+        suspendProcessing(true);
+        prepareOversampled(getSampleRate(), getBlockSize());
+        suspendProcessing(false);
     }
 
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-                                                                                                          getSampleRate(),
-                                                                                                          2 * (chainSettings.highCutSlope + 1));
-    auto& leftHighCut = leftChain.get<ChainPosition::HighCut>();
-    leftHighCut.setBypassed<0>(true);
-    leftHighCut.setBypassed<1>(true);
-    leftHighCut.setBypassed<2>(true);
-    leftHighCut.setBypassed<3>(true);
-
-    switch (chainSettings.highCutSlope)
-    {
-    case Slope12:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        *leftHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        leftHighCut.setBypassed<3>(false);
-        break;
+    const auto previousLatency = getLatencySamples();
+    updateLatency();
+
+    if (getLatencySamples() != previousLatency)
+        updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withLatencyChanged(true));   // the host compensates the new figure
+}
+
+void NewProjectAudioProcessor::updateLatency()
+{
+    if (linearPhaseEQ.isEnabled())
+        setLatencySamples(linearPhaseEQ.getLatencySamples());   // the linear-phase kernel runs at the host rate, without oversampling
+    else if (floatOversampler != nullptr)
+        setLatencySamples(juce::roundToInt(floatOversampler->getLatencyInSamples()));   // whole samples, the oversampler was built with integer latency
+    else
+        setLatencySamples(0);
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::applyCoefficients(SIMDFilterChain<SampleType>& filterChain, const DesignedCoefficients& designed, int numSets)
+{
+    // a few dozen plain copies into the chain's biquad bank; linked, every lane runs the same sections, otherwise
+    // each channel set only writes its own lanes and both channels still go through the chain in one pass
+    filterChain.setNumChannelSets(numSets);
+
+    for (int set = 0; set < numSets; ++set)
+    {
+        const auto& sections = designed.sets[(size_t) set];
+        const auto channelSet = numSets == 1 ? SIMDFilterChain<SampleType>::allChannelSets : set;
+
+        filterChain.setStageSections(ChainPosition::LowCut, sections.lowCut.data(), sections.numLowCutSections, channelSet);   // Slope48 uses all four sections, Slope12 only the first one
+        filterChain.setStageSections(ChainPosition::Peak, &sections.peak, 1, channelSet);
+        filterChain.setStageSections(ChainPosition::HighCut, sections.highCut.data(), sections.numHighCutSections, channelSet);
     }
+}
+
+void NewProjectAudioProcessor::applyCoefficients(const DesignedCoefficients& designed)
+{
+    const auto newStereoMode = canSplitChannels ? static_cast<StereoMode>(designed.stereoMode) : stereoLinked;
 
-    auto& rightHighCut = rightChain.get<ChainPosition::HighCut>();
-    rightHighCut.setBypassed<0>(true);
-    rightHighCut.setBypassed<1>(true);
-    rightHighCut.setBypassed<2>(true);
-    rightHighCut.setBypassed<3>(true);
-
-    switch (chainSettings.highCutSlope)
-    {
-    case Slope12:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        *rightHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        rightHighCut.setBypassed<3>(false);
-        break;
+    if (newStereoMode != stereoMode)
+    {
+        // the states hold mid/side or left/right history, which means nothing in the other mode
+        stereoMode = newStereoMode;
+        floatChain.reset();
+        doubleChain.reset();
     }
 
+    // both chains follow every set, so nothing is stale whichever precision the host picks next
+    const auto numSets = stereoMode == stereoLinked ? 1 : designed.numSets;
+    applyCoefficients(floatChain, designed, numSets);
+    applyCoefficients(doubleChain, designed, numSets);
+    updateActiveStages(designed);
+}
+
+void NewProjectAudioProcessor::updateActiveStages(const DesignedCoefficients& designed)
+{
+    // bypassed or neutral bands crossfade out of the chain and then cost nothing, calling this with unchanged flags is free
+    auto update = [&designed](auto& filterChain)
+    {
+        const auto numSets = filterChain.getNumChannelSets();
+
+        for (int set = 0; set < numSets; ++set)
+        {
+            const auto& sections = designed.sets[(size_t) set];
+            const auto channelSet = numSets == 1 ? std::decay_t<decltype(filterChain)>::allChannelSets : set;
+
+            filterChain.setStageActive(ChainPosition::LowCut, sections.lowCutActive, channelSet);
+            filterChain.setStageActive(ChainPosition::Peak, sections.peakActive, channelSet);
+            filterChain.setStageActive(ChainPosition::HighCut, sections.highCutActive, channelSet);
+        }
+    };
+
+    update(floatChain);
+    update(doubleChain);
 }
 
 void NewProjectAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    isPrepared = false;   // an oversampling change now waits for the next prepareToPlay
+    coefficientDesigner.release();
+    linearPhaseEQ.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -304,17 +340,25 @@ bool NewProjectAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
     return true;
 #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Every channel just gets its own filter state, so any layout works: mono, stereo, 5.1, 7.1.4, ambisonics...
     // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // load plugins that support stereo bus layouts, which is why stereo stays the default in the constructor.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
 #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // the sidechain is only a detector input for the dynamic peak: off, mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        const auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (! sidechain.isDisabled() && sidechain != juce::AudioChannelSet::mono() && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
 #endif
 
     return true;
@@ -323,9 +367,51 @@ bool NewProjectAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
 #endif
 
 void NewProjectAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer);
+}
+
+void NewProjectAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer);   // same chain in double precision, so a 64 bit host needs no conversion
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer)
+{
+    RealtimeSafetyAudit::ScopedRealtimeSection realtimeSection;   // audit builds report anything in the whole callback that allocates, locks or blocks
+
+    // while the load meter is off this is one relaxed load and a store, the ticks are only cleared for blocks that
+    // are timed, and every stage timer below costs a branch on the plain bool that goes the same way all block long
+    blockTimings.enabled = loadMeter.isEnabled();
+
+    if (blockTimings.enabled)
+        blockTimings.ticks = {};
+
+    {
+        DSPLoadMeter::ScopedStageTimer totalTimer(blockTimings, DSPLoadMeter::total);
+
+        // the analyzer taps the input before and the output after the EQ, they are skipped while no view shows it
+        const auto analyzerIsActive = analyzer.isActive();
+
+        if (analyzerIsActive)
+            analyzer.pushSamples(SpectrumAnalyzer::preEQ, buffer, getMainBusNumInputChannels());
+
+        processBuffer(buffer);
+
+        if (analyzerIsActive)
+            analyzer.pushSamples(SpectrumAnalyzer::postEQ, buffer, getMainBusNumInputChannels());
+    }
+
+    if (blockTimings.enabled)
+        loadMeter.pushBlock(blockTimings, buffer.getNumSamples());
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::processBuffer(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
+    auto totalNumInputChannels = getMainBusNumInputChannels();   // the sidechain channels come after these and are never filtered
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     // In case we have more outputs than inputs, this code clears any output
@@ -344,206 +430,416 @@ void NewProjectAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, ju
     // Alternatively, you can process the samples with the channels
     // interleaved by keeping the same state.
 
+    // silent input only needs filtering until the filters have rung out, after that the output is silent too
+    const auto inputIsSilent = isSilent(buffer, totalNumInputChannels);
+    silentInputSamples = inputIsSilent ? juce::jmin(silentInputSamples + buffer.getNumSamples(), 1 << 30) : 0;
+
+    if (inputIsSilent && isIdle)
+        return;
+
+    if (isIdle)
+        resumeFromIdle();
+
+    const auto linearPhase = linearPhaseEQ.isEnabled();
+
+    if (linearPhase != wasLinearPhase)   // the latency jumps anyway, so start whichever mode takes over from clean state
+    {
+        wasLinearPhase = linearPhase;
+        getFilterChain<SampleType>().reset();
+        linearPhaseEQ.reset();
+    }
+
+    // the dynamic peak listens before the EQ touches the block, to the sidechain when asked to and the host connected one
+    const auto chainHasDynamicPeak = dynamicPeakThisBlock;
+    dynamicPeakThisBlock = ! linearPhase && dynamicBand.isEnabled() && apvts.getRawParameterValue("Peak Bypassed")->load() < 0.5f;
+
+    if (chainHasDynamicPeak && ! dynamicPeakThisBlock)
+        restoreStaticPeak();
+
+    if (dynamicPeakThisBlock)
+    {
+        DSPLoadMeter::ScopedStageTimer designTimer(blockTimings, DSPLoadMeter::coefficientDesign);
+        const auto sidechainChannels = getBusCount(true) > 1 ? getChannelCountOfBus(true, 1) : 0;
+
+        if (dynamicBand.usesSidechain() && sidechainChannels > 0)
+            dynamicBand.analyse(getBusBuffer(buffer, true, 1), sidechainChannels, buffer.getNumSamples());
+        else
+            dynamicBand.analyse(buffer, totalNumInputChannels, buffer.getNumSamples());
+    }
+
+    auto block = juce::dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, (size_t) totalNumInputChannels);
+
+    if (linearPhase)
+        linearPhaseEQ.process(block);
+    else
+        processOversampled(block);
+
+    // a linear-phase kernel can still have its main lobe to come after a quiet block, wait until its whole length has passed;
+    // the IIR chain has rung out once its biquad states are quiet, a quiet output alone can still hide a ringing band
+    const auto hasRungOut = linearPhase ? silentInputSamples >= linearPhaseEQ.getKernelLength()
+                                        : getFilterChain<SampleType>().hasRungOut(static_cast<SampleType>(silenceThreshold));
+
+    if (inputIsSilent && hasRungOut && isSilent(buffer, totalNumInputChannels))
+    {
+        getFilterChain<SampleType>().reset();   // whatever is left in the states is below the threshold, start from exact zeros next time
+        linearPhaseEQ.reset();
+        dynamicBand.reset();
+
+        if (auto* oversampler = getOversampler<SampleType>())
+            oversampler->reset();
+
+        isIdle = true;
+    }
+}
+
+void NewProjectAudioProcessor::restoreStaticPeak()
+{
+    // the chains still run the detector's last section, which can be a good few dB under the band's own gain, and
+    // the designer only hands over the static peak a few blocks from now, so design it here for the very next sample
+    DSPLoadMeter::ScopedStageTimer designTimer(blockTimings, DSPLoadMeter::coefficientDesign);
+    const auto coefficients = coefficientDesigner.makeChainCoefficients(getChainSettings(apvts, 0));
+
+    auto restore = [&coefficients](auto& filterChain)
+    {
+        // the dynamic peak is a band of the first channel set, see processChains
+        const auto channelSet = filterChain.getNumChannelSets() == 1 ? std::decay_t<decltype(filterChain)>::allChannelSets : 0;
+        filterChain.setStageSections(ChainPosition::Peak, &coefficients.peak, 1, channelSet);
+        filterChain.setStageActive(ChainPosition::Peak, coefficients.peakActive, channelSet);
+    };
+
+    restore(floatChain);
+    restore(doubleChain);
+}
+
+template <typename SampleType>
+bool NewProjectAudioProcessor::isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (buffer.getMagnitude(channel, 0, buffer.getNumSamples()) > silenceThreshold)
+            return false;
+
+    return true;
+}
+
+void NewProjectAudioProcessor::resumeFromIdle()
+{
+    isIdle = false;
+
+    // the smoothers stood still while we were idle, jump them to the current settings rather than ramping from stale values
+    if (wasSmoothing)
+    {
+        DSPLoadMeter::ScopedStageTimer designTimer(blockTimings, DSPLoadMeter::coefficientDesign);
+        resetSmoothers();
+        applyCoefficients(smoothedCoefficients);
+    }
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::processOversampled(juce::dsp::AudioBlock<SampleType>& block)
+{
+    auto* oversampler = getOversampler<SampleType>();
+
+    if (oversampler == nullptr)
+    {
+        processFilters(block);
+        return;
+    }
+
+    auto oversampledBlock = oversampler->processSamplesUp(block);   // lives in the oversampler's own buffer, factor times longer
+    processFilters(oversampledBlock);
+    oversampler->processSamplesDown(block);
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::processFilters(juce::dsp::AudioBlock<SampleType>& block)
+{
+    const DesignedCoefficients* designed = nullptr;
+    int subBlockSize = 0, rampLength = 0;
+
+    {
+        DSPLoadMeter::ScopedStageTimer fetchTimer(blockTimings, DSPLoadMeter::parameterFetch);
+
+        // pick up a new coefficient set if the designer finished one, otherwise keep running on the previous one
+        designed = coefficientDesigner.pullLatest();
+        if (designed != nullptr)
+            currentDesigned = designed;
+
+        static constexpr int subBlockSizes[] = { 0, 16, 32, 64, 128 };   // same order as the "Smoothing" choices
+        subBlockSize = subBlockSizes[juce::jlimit(0, 4, (int) smoothingParameter->load())];
+
+        // sample accurate automation: the value the host hands over is where its automation is at the end of the block
+        // (the VST3 wrapper keeps the last point of each block), so every band ramps linearly there from where it was
+        // at the end of the previous block. That turns the once-a-block step into a per-block linear ramp, but any
+        // shape the automation has inside a block (a curve, a jump in the middle) is lost, more so at large buffer sizes
+        if (sampleAccurateParameter->load() > 0.5f)
+        {
+            rampLength = (int) block.getNumSamples();
+
+            if (subBlockSize == 0)
+                subBlockSize = automationSubBlockSize;
+        }
+    }
+
+    if (subBlockSize > 0)
+    {
+        processSmoothed(block, subBlockSize, rampLength);
+        return;
+    }
+
+    if (designed != nullptr || wasSmoothing)   // coming back from smoothing, the chains still point at the smoothed set
+    {
+        DSPLoadMeter::ScopedStageTimer designTimer(blockTimings, DSPLoadMeter::coefficientDesign);
+        applyCoefficients(*currentDesigned);
+    }
+
+    wasSmoothing = false;
+
+    if (dynamicPeakThisBlock)   // straight from the parameters, the designer's set may still be a block behind
+        dynamicBand.setPeak(apvts.getRawParameterValue("Peak Freq")->load(), apvts.getRawParameterValue("Peak Quality")->load(),
+                            apvts.getRawParameterValue("Peak Gain")->load());
+
+    processChains(block);
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::processChains(juce::dsp::AudioBlock<SampleType>& block, int startSample)
+{
+    static_assert(DSPLoadMeter::peak - DSPLoadMeter::lowCut == SIMDFilterChain<SampleType>::peakStage
+                  && DSPLoadMeter::highCut - DSPLoadMeter::lowCut == SIMDFilterChain<SampleType>::highCutStage,
+                  "the chain writes its stage timings straight into the meter's filter stages");
 
-    auto chainSettings = getChainSettings(apvts);
-    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), 
-                                                                                chainSettings.peakFreq,
-                                                                                chainSettings.peakQuality,
-                                                                                juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    auto* stageTicks = blockTimings.enabled ? blockTimings.ticks.data() + DSPLoadMeter::lowCut : nullptr;
+    auto& chain = getFilterChain<SampleType>();
 
-    if (peakCoefficients)
+    // the matrix is linear, so it can sit inside the oversampling as well as outside, here it always matches the chain's mode
+    const auto isMidSide = stereoMode == midSide;
+
+    if (isMidSide)
+        encodeMidSide(block);
+
+    if (! dynamicPeakThisBlock)
     {
-        auto& peak = rightChain.get<ChainPosition::Peak>();
-        *peak.coefficients = *peakCoefficients;
+        chain.process(block, stageTicks);   // channels go through the chain together, one per SIMD lane
+
+        if (isMidSide)
+            decodeMidSide(block);
+
+        return;
     }
 
-    if (peakCoefficients)
+    // the dynamic peak is a band of the first channel set, mid or left when the channels are split
+    const auto dynamicChannelSet = chain.getNumChannelSets() == 1 ? SIMDFilterChain<SampleType>::allChannelSets : 0;
+
+    // the dynamic peak gets a new section every updateInterval host samples, which is more chain samples when oversampling
+    const auto interval = DynamicBand::updateInterval << oversamplingOrder;
+    const auto numSamples = (int) block.getNumSamples();
+
+    for (int start = 0; start < numSamples;)
     {
-        auto& peak = leftChain.get<ChainPosition::Peak>();
-        *peak.coefficients = *peakCoefficients;
+        const auto position = startSample + start;
+        const auto length = juce::jmin(interval - position % interval, numSamples - start);
+
+        {
+            DSPLoadMeter::ScopedStageTimer designTimer(blockTimings, DSPLoadMeter::coefficientDesign);
+            const auto section = dynamicBand.makePeakSection(position / interval);
+            chain.setStageSections(ChainPosition::Peak, &section, 1, dynamicChannelSet);
+        }
+
+        auto subBlock = block.getSubBlock((size_t) start, (size_t) length);
+        chain.process(subBlock, stageTicks);
+        start += length;
     }
 
-    // *leftChain.get<ChainPosition::Peak().coefficients = *peakCoefficients;
-    // *leftChain.get <ChainPosition::Peak().coefficients = *peakCoefficients;
-
-
-
-    auto cutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-                                                                                                       getSampleRate(),
-                                                                                                       2 * (chainSettings.lowCutSlope + 1));
-    auto& leftLowCut = leftChain.get < ChainPosition::LowCut>();
-    leftLowCut.setBypassed<0>(true);
-    leftLowCut.setBypassed<1>(true);
-    leftLowCut.setBypassed<2>(true);
-    leftLowCut.setBypassed<3>(true);
-
-    switch (chainSettings.lowCutSlope)
-    {
-    case Slope12:
-
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *cutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *cutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *cutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
-        leftLowCut.setBypassed<0>(false);
-        *leftLowCut.get<1>().coefficients = *cutCoefficients[1];
-        leftLowCut.setBypassed<1>(false);
-        *leftLowCut.get<2>().coefficients = *cutCoefficients[2];
-        leftLowCut.setBypassed<2>(false);
-        *leftLowCut.get<3>().coefficients = *cutCoefficients[3];
-        leftLowCut.setBypassed<3>(false);
-
-        break;
+    if (isMidSide)
+        decodeMidSide(block);
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::encodeMidSide(juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    jassert(block.getNumChannels() == 2);
+    auto* left = block.getChannelPointer(0);
+    auto* right = block.getChannelPointer(1);
+
+    for (size_t i = 0; i < block.getNumSamples(); ++i)
+    {
+        const auto mid = (left[i] + right[i]) * SampleType(0.5);
+        const auto side = (left[i] - right[i]) * SampleType(0.5);
+        left[i] = mid;
+        right[i] = side;
     }
+}
 
+template <typename SampleType>
+void NewProjectAudioProcessor::decodeMidSide(juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    jassert(block.getNumChannels() == 2);
+    auto* mid = block.getChannelPointer(0);
+    auto* side = block.getChannelPointer(1);
 
-    auto& rightLowCut = rightChain.get < ChainPosition::LowCut>();
-    rightLowCut.setBypassed<0>(true);
-    rightLowCut.setBypassed<1>(true);
-    rightLowCut.setBypassed<2>(true);
-    rightLowCut.setBypassed<3>(true);
-
-    switch (chainSettings.lowCutSlope)
-    {
-    case Slope12:
-
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *cutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *cutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *cutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
-        rightLowCut.setBypassed<0>(false);
-        *rightLowCut.get<1>().coefficients = *cutCoefficients[1];
-        rightLowCut.setBypassed<1>(false);
-        *rightLowCut.get<2>().coefficients = *cutCoefficients[2];
-        rightLowCut.setBypassed<2>(false);
-        *rightLowCut.get<3>().coefficients = *cutCoefficients[3];
-        rightLowCut.setBypassed<3>(false);
-
-        break;
+    for (size_t i = 0; i < block.getNumSamples(); ++i)
+    {
+        const auto left = mid[i] + side[i];
+        const auto right = mid[i] - side[i];
+        mid[i] = left;
+        side[i] = right;
     }
+}
+
+template <typename SampleType>
+void NewProjectAudioProcessor::processSmoothed(juce::dsp::AudioBlock<SampleType>& block, int subBlockSize, int rampLength)
+{
+    // the coefficients are redesigned every subBlockSize samples while a ramp is moving, so the sound no longer
+    // depends on the host buffer size, smaller sub-blocks trade CPU for smoother sweeps
+    std::array<ChainSettings, DesignedCoefficients::maxChannelSets> chainSettings;
+    StereoMode newStereoMode = stereoLinked;
+
+    {
+        DSPLoadMeter::ScopedStageTimer fetchTimer(blockTimings, DSPLoadMeter::parameterFetch);
+        newStereoMode = getStereoMode(apvts);
 
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-        getSampleRate(),
-        2 * (chainSettings.highCutSlope + 1));
-    auto& leftHighCut = leftChain.get<ChainPosition::HighCut>();
-    leftHighCut.setBypassed<0>(true);
-    leftHighCut.setBypassed<1>(true);
-    leftHighCut.setBypassed<2>(true);
-    leftHighCut.setBypassed<3>(true);
-
-    switch (chainSettings.highCutSlope)
-    {
-    case Slope12:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *leftHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        leftHighCut.setBypassed<0>(false);
-        *leftHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        leftHighCut.setBypassed<1>(false);
-        *leftHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        leftHighCut.setBypassed<2>(false);
-        *leftHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        leftHighCut.setBypassed<3>(false);
-        break;
+        for (int set = 0; set < (newStereoMode == stereoLinked ? 1 : DesignedCoefficients::maxChannelSets); ++set)
+            chainSettings[(size_t) set] = getChainSettings(apvts, set);
     }
 
-    auto& rightHighCut = rightChain.get<ChainPosition::HighCut>();
-    rightHighCut.setBypassed<0>(true);
-    rightHighCut.setBypassed<1>(true);
-    rightHighCut.setBypassed<2>(true);
-    rightHighCut.setBypassed<3>(true);
-
-    switch (chainSettings.highCutSlope)
-    {
-    case Slope12:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        break;
-    case Slope24:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        break;
-    case Slope36:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        break;
-    case Slope48:
-        *rightHighCut.get<0>().coefficients = *highCutCoefficients[0];
-        rightHighCut.setBypassed<0>(false);
-        *rightHighCut.get<1>().coefficients = *highCutCoefficients[1];
-        rightHighCut.setBypassed<1>(false);
-        *rightHighCut.get<2>().coefficients = *highCutCoefficients[2];
-        rightHighCut.setBypassed<2>(false);
-        *rightHighCut.get<3>().coefficients = *highCutCoefficients[3];
-        rightHighCut.setBypassed<3>(false);
-        break;
+    {
+        DSPLoadMeter::ScopedStageTimer designTimer(blockTimings, DSPLoadMeter::coefficientDesign);
+
+        if (! wasSmoothing || newStereoMode != smoothedCoefficients.stereoMode)
+        {
+            resetSmoothers();   // start ramping from where the designer left the chains, a new stereo mode starts over anyway
+            applyCoefficients(smoothedCoefficients);
+            wasSmoothing = true;
+        }
+
+        // a new slope or bypass is designed with the first sub-block below, along with the ramps
+        for (int set = 0; set < smoothedCoefficients.numSets; ++set)
+            smoothers[(size_t) set].setTarget(chainSettings[(size_t) set], rampLength);
     }
 
+    const auto numSamples = (int) block.getNumSamples();
 
-    juce::dsp::AudioBlock<float> block(buffer);
+    for (int start = 0; start < numSamples; start += subBlockSize)
+    {
+        const auto length = juce::jmin(subBlockSize, numSamples - start);
+
+        {
+            DSPLoadMeter::ScopedStageTimer designTimer(blockTimings, DSPLoadMeter::coefficientDesign);
+            updateSmoothedCoefficients(length);
+            updateActiveStages(smoothedCoefficients);   // e.g. the peak only drops out once its gain has ramped all the way to 0 dB
+
+            if (dynamicPeakThisBlock)
+            {
+                const auto& smoother = smoothers[0];
+                dynamicBand.setPeak(smoother.peakFreq.getCurrentValue(), smoother.peakQuality.getCurrentValue(), smoother.peakGain.getCurrentValue());
+            }
+        }
+
+        auto subBlock = block.getSubBlock((size_t) start, (size_t) length);
+        processChains(subBlock, start);
+    }
+}
 
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+void NewProjectAudioProcessor::resetSmoothers()
+{
+    const auto newStereoMode = getStereoMode(apvts);
+    smoothedCoefficients.stereoMode = newStereoMode;
+    smoothedCoefficients.numSets = newStereoMode == stereoLinked ? 1 : DesignedCoefficients::maxChannelSets;
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    for (int set = 0; set < smoothedCoefficients.numSets; ++set)
+    {
+        const auto chainSettings = getChainSettings(apvts, set);
+        smoothers[(size_t) set].reset(chainSettings);
+        smoothedCoefficients.sets[(size_t) set].assign(coefficientDesigner.makeChainCoefficients(chainSettings));
+    }
+}
+
+void NewProjectAudioProcessor::updateSmoothedCoefficients(int numSamples)
+{
+    // each channel set is only redesigned while its own ramps move, a side-only sweep leaves the mid set alone
+    auto anyDesigned = false;
+
+    for (int set = 0; set < smoothedCoefficients.numSets; ++set)
+    {
+        auto& smoother = smoothers[(size_t) set];
+
+        if (! smoother.needsDesign())
+            continue;   // settled, the smoothed set already matches the targets
+
+        smoothedCoefficients.sets[(size_t) set].assign(coefficientDesigner.makeChainCoefficients(smoother.skip(numSamples)));
+        anyDesigned = true;
+    }
+
+    if (anyDesigned)
+        applyCoefficients(smoothedCoefficients);   // the chains hold copies in their biquad banks, so every redesign is handed over
+}
+
+void NewProjectAudioProcessor::ChainSmoother::prepare(double sampleRate)
+{
+    defaultRampLength = juce::roundToInt(sampleRate * smoothingRampSeconds);
+    rampLength = 0;
+    setRampLength(defaultRampLength);
+}
+
+void NewProjectAudioProcessor::ChainSmoother::setRampLength(int numSamples)
+{
+    if (numSamples == rampLength)
+        return;
+
+    // SmoothedValue::reset jumps to the target, which is where a ramp of the previous block's length has arrived by now
+    rampLength = numSamples;
+
+    for (auto* smoother : { &peakFreq, &peakQuality, &lowCutFreq, &highCutFreq })
+        smoother->reset(rampLength);
+    peakGain.reset(rampLength);
+}
+
+void NewProjectAudioProcessor::ChainSmoother::reset(const ChainSettings& chainSettings)
+{
+    peakFreq.setCurrentAndTargetValue(chainSettings.peakFreq);
+    peakGain.setCurrentAndTargetValue(chainSettings.peakGainInDecibels);
+    peakQuality.setCurrentAndTargetValue(chainSettings.peakQuality);
+    lowCutFreq.setCurrentAndTargetValue(chainSettings.lowCutFreq);
+    highCutFreq.setCurrentAndTargetValue(chainSettings.highCutFreq);
+    switched = chainSettings;
+    hasSwitched = false;
+}
+
+void NewProjectAudioProcessor::ChainSmoother::setTarget(const ChainSettings& chainSettings, int newRampLength)
+{
+    setRampLength(newRampLength > 0 ? newRampLength : defaultRampLength);
+
+    peakFreq.setTargetValue(chainSettings.peakFreq);
+    peakGain.setTargetValue(chainSettings.peakGainInDecibels);
+    peakQuality.setTargetValue(chainSettings.peakQuality);
+    lowCutFreq.setTargetValue(chainSettings.lowCutFreq);
+    highCutFreq.setTargetValue(chainSettings.highCutFreq);
+
+    if (chainSettings.lowCutSlope != switched.lowCutSlope || chainSettings.highCutSlope != switched.highCutSlope
+        || chainSettings.lowCutBypassed != switched.lowCutBypassed || chainSettings.peakBypassed != switched.peakBypassed
+        || chainSettings.highCutBypassed != switched.highCutBypassed || chainSettings.peakDynamic != switched.peakDynamic)
+    {
+        switched = chainSettings;
+        hasSwitched = true;
+    }
+}
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+bool NewProjectAudioProcessor::ChainSmoother::needsDesign() const noexcept
+{
+    return hasSwitched || peakFreq.isSmoothing() || peakGain.isSmoothing() || peakQuality.isSmoothing()
+        || lowCutFreq.isSmoothing() || highCutFreq.isSmoothing();
+}
+
+ChainSettings NewProjectAudioProcessor::ChainSmoother::skip(int numSamples)
+{
+    auto smoothedSettings = switched;   // slopes and flags as they are now
+    smoothedSettings.peakFreq = peakFreq.skip(numSamples);
+    smoothedSettings.peakGainInDecibels = peakGain.skip(numSamples);
+    smoothedSettings.peakQuality = peakQuality.skip(numSamples);
+    smoothedSettings.lowCutFreq = lowCutFreq.skip(numSamples);
+    smoothedSettings.highCutFreq = highCutFreq.skip(numSamples);
+    hasSwitched = false;
+    return smoothedSettings;
 }
 
 //==============================================================================
@@ -559,37 +855,219 @@ juce::AudioProcessorEditor* NewProjectAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// binary state: magic, format version, parameter count, then (ID, value) pairs, values in plain units so a
+// changed range or skew doesn't move a saved setting. Bump stateVersion when this changes, readBinaryState then
+// has to bring the values of the older versions up to date (a renamed ID, a changed unit) before applying them.
+static const juce::uint32 stateMagic = juce::ByteOrder::littleEndianInt("EQst");
+static constexpr juce::uint32 stateVersion = 1;
+
 void NewProjectAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // No XML here: a few hundred bytes of binary are much quicker to write and, above all, to read back
+    // when a session with hundreds of instances loads.
+    juce::MemoryOutputStream stream(destData, false);
+    const auto& parameters = getParameters();
+
+    stream.writeInt((int) stateMagic);
+    stream.writeInt((int) stateVersion);
+    stream.writeInt(parameters.size());
+
+    for (auto* param : parameters)
+    {
+        if (auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param))
+        {
+            stream.writeString(rangedParam->paramID);
+            stream.writeFloat(rangedParam->convertFrom0to1(rangedParam->getValue()));
+        }
+    }
 }
 
 void NewProjectAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    isRestoringState = true;   // every parameter change would otherwise ask the designer (and the analyzer) for a new design
+
+    // the first version of the plugin didn't save anything, so every state a host hands back was written by
+    // getStateInformation() above, anything else is left alone
+    if (! readBinaryState(data, sizeInBytes))
+        jassertfalse;
+
+    isRestoringState = false;
+    coefficientDesigner.parametersChanged();   // one design for the whole restore
+    analyzer.parametersChanged();
+    linearPhaseEQ.parametersChanged();
+    setupMayHaveChanged.store(true, std::memory_order_release);
+}
+
+bool NewProjectAudioProcessor::readBinaryState(const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream(data, (size_t) juce::jmax(0, sizeInBytes), false);
+
+    if (stream.getTotalLength() < 12 || (juce::uint32) stream.readInt() != stateMagic)
+        return false;
+
+    const auto version = (juce::uint32) stream.readInt();
+    const auto numValues = stream.readInt();
+
+    if (version > stateVersion || numValues < 0)
+    {
+        jassertfalse;   // saved by a newer build, we don't know what its values mean
+        return true;    // it was ours though
+    }
+
+    std::map<juce::String, float> values;
+
+    for (int i = 0; i < numValues && ! stream.isExhausted(); ++i)
+    {
+        auto parameterID = stream.readString();
+        values[parameterID] = stream.readFloat();
+    }
+
+    // a state is always complete, anything it doesn't mention goes back to its default
+    for (auto* param : getParameters())
+    {
+        if (auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param))
+        {
+            const auto found = values.find(rangedParam->paramID);
+            const auto normalised = found != values.end() ? rangedParam->convertTo0to1(found->second)
+                                                          : rangedParam->getDefaultValue();
+
+            if (normalised != rangedParam->getValue())   // unchanged parameters don't need to notify anyone
+                rangedParam->setValueNotifyingHost(normalised);
+        }
+    }
+
+    return true;
 }
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {    //getter function that pulls the current values from the plugin parameters 
+
+// the band parameters of each channel set: the first set keeps the original IDs, so older sessions load unchanged
+// and the linked mode is exactly what it always was; string literals, so the audio thread can look them up too
+struct BandParameterIDs
+{
+    const char* lowCutFreq; const char* highCutFreq;
+    const char* peakFreq; const char* peakGain; const char* peakQuality;
+    const char* lowCutSlope; const char* highCutSlope;
+    const char* lowCutBypassed; const char* peakBypassed; const char* highCutBypassed;
+};
+
+static constexpr BandParameterIDs bandParameterIDs[] =
+{
+    { "LowCut Freq", "HighCut Freq", "Peak Freq", "Peak Gain", "Peak Quality",
+      "LowCut Slope", "HighCut Slope", "LowCut Bypassed", "Peak Bypassed", "HighCut Bypassed" },
+    { "Ch2 LowCut Freq", "Ch2 HighCut Freq", "Ch2 Peak Freq", "Ch2 Peak Gain", "Ch2 Peak Quality",
+      "Ch2 LowCut Slope", "Ch2 HighCut Slope", "Ch2 LowCut Bypassed", "Ch2 Peak Bypassed", "Ch2 HighCut Bypassed" }
+};
+
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts, int channelSet) {    //getter function that pulls the current values from the plugin parameters 
 
     ChainSettings settings; // this struct will be filled with the current values from the plugin AudioProcessorValueTreeState parameters
+    const auto& ids = bandParameterIDs[juce::jlimit(0, 1, channelSet)];
 
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();   // looks up the parameter " LowCut Freq" from the AudioProcessorValueTreeState , loads its cuttent value, and stores it in settings.lowCutFreq. The point of using .load() here is to safely read the value fromm a std::atomic<float>, which is the type returned by getRawParameterValue() in Juce
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    settings.lowCutFreq = apvts.getRawParameterValue(ids.lowCutFreq)->load();   // looks up the parameter " LowCut Freq" from the AudioProcessorValueTreeState , loads its cuttent value, and stores it in settings.lowCutFreq. The point of using .load() here is to safely read the value fromm a std::atomic<float>, which is the type returned by getRawParameterValue() in Juce
+    settings.highCutFreq = apvts.getRawParameterValue(ids.highCutFreq)->load();
+    settings.peakFreq = apvts.getRawParameterValue(ids.peakFreq)->load();
+    settings.peakGainInDecibels = apvts.getRawParameterValue(ids.peakGain)->load();
+    settings.peakQuality = apvts.getRawParameterValue(ids.peakQuality)->load();
+    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue(ids.lowCutSlope)->load());
+    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue(ids.highCutSlope)->load());
 
-    // settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load() > 0.5f;
-    // settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
-    // settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load() > 0.5f;
+    settings.lowCutBypassed = apvts.getRawParameterValue(ids.lowCutBypassed)->load() > 0.5f;
+    settings.peakBypassed = apvts.getRawParameterValue(ids.peakBypassed)->load() > 0.5f;
+    settings.highCutBypassed = apvts.getRawParameterValue(ids.highCutBypassed)->load() > 0.5f;
+    settings.peakDynamic = channelSet == 0 && apvts.getRawParameterValue("Peak Dynamic")->load() > 0.5f;   // only the first set's peak has a dynamic mode
 
 
     return settings;
 }
+
+StereoMode getStereoMode(juce::AudioProcessorValueTreeState& apvts)
+{
+    return static_cast<StereoMode>(juce::jlimit(0, 2, (int) apvts.getRawParameterValue("Stereo Mode")->load()));
+}
+
+double getButterworthSectionQ(int numSections, int section)
+{
+    // Q of each biquad in an even order Butterworth cascade, exactly as FilterDesign<float> computes it
+    const auto order = 2 * numSections;
+    return 1.0 / (2.0 * std::cos((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+}
+
+void setActiveBands(ChainCoefficients& coefficients, const ChainSettings& chainSettings)
+{
+    // a band only stays in the per-sample loop when it is not bypassed and can actually change the sound:
+    // a peak at 0 dB is an identity filter (unless it is dynamic and can move away from 0 dB any moment), and the
+    // cuts parked at the very ends of their range count as switched off
+    coefficients.lowCutActive = ! chainSettings.lowCutBypassed && chainSettings.lowCutFreq > 20.f;
+    coefficients.peakActive = ! chainSettings.peakBypassed && (chainSettings.peakGainInDecibels != 0.f || chainSettings.peakDynamic);
+    coefficients.highCutActive = ! chainSettings.highCutBypassed && chainSettings.highCutFreq < 20000.f;
+}
+
+static double getSectionTailLengthSamples(const BiquadCoefficients& section)
+{
+    // the impulse response dies away like r^n, where r is the radius of the section's largest pole
+    const auto a1 = static_cast<double>(section[4]) / section[3];
+    const auto a2 = static_cast<double>(section[5]) / section[3];
+    const auto discriminant = a1 * a1 - 4.0 * a2;
+
+    const auto radius = discriminant < 0.0 ? std::sqrt(a2)
+                                           : (std::abs(a1) + std::sqrt(discriminant)) * 0.5;
+
+    if (radius <= 0.0 || radius >= 1.0)
+        return 0.0;   // nothing rings (or, never for our designs, it would ring forever), don't report an infinite tail
+
+    return std::log(static_cast<double>(silenceThreshold)) / std::log(radius);
+}
+
+double getTailLengthSamples(const ChainCoefficients& coefficients)
+{
+    // the bands are in series, so adding up their tails is a safe upper bound
+    double tail = 0.0;
+
+    if (coefficients.peakActive)
+        tail += getSectionTailLengthSamples(coefficients.peak);
+
+    if (coefficients.lowCutActive)
+        for (int i = 0; i < coefficients.lowCut.numSections; ++i)
+            tail += getSectionTailLengthSamples(coefficients.lowCut.sections[(size_t) i]);
+
+    if (coefficients.highCutActive)
+        for (int i = 0; i < coefficients.highCut.numSections; ++i)
+            tail += getSectionTailLengthSamples(coefficients.highCut.sections[(size_t) i]);
+
+    return tail;
+}
+
+template <typename SectionDesign>
+static CutCoefficients makeButterworthCut(float frequency, double sampleRate, Slope slope, SectionDesign&& makeSection)
+{
+    // same cascade FilterDesign<float>::designIIR*HighOrderButterworthMethod builds for an even order,
+    // but written into a fixed size array instead of a ReferenceCountedArray, so nothing is allocated
+    CutCoefficients cut;
+    cut.numSections = slope + 1;
+
+    for (int i = 0; i < cut.numSections; ++i)
+        cut.sections[(size_t) i] = makeSection(sampleRate, frequency, getButterworthSectionQ(cut.numSections, i));
+
+    return cut;
+}
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<double>;
+
+    ChainCoefficients coefficients;
+    coefficients.peak = ArrayCoefficients::makePeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality,
+                                                          juce::Decibels::decibelsToGain(static_cast<double>(chainSettings.peakGainInDecibels)));
+
+    coefficients.lowCut = makeButterworthCut(chainSettings.lowCutFreq, sampleRate, chainSettings.lowCutSlope,
+                                             [](double rate, double freq, double q) { return ArrayCoefficients::makeHighPass(rate, freq, q); });
+    coefficients.highCut = makeButterworthCut(chainSettings.highCutFreq, sampleRate, chainSettings.highCutSlope,
+                                              [](double rate, double freq, double q) { return ArrayCoefficients::makeLowPass(rate, freq, q); });
+    return coefficients;
+}
+
 juce::AudioProcessorValueTreeState::ParameterLayout NewProjectAudioProcessor::createParameterLayout()
 {
 
@@ -639,6 +1117,58 @@ juce::AudioProcessorValueTreeState::ParameterLayout NewProjectAudioProcessor::cr
     layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed", "HighCut Bypassed", false));    // Creating AudioParameterBool object. Represents a true/false parameter(like a toggle switch or on/off button)  false or true - defaul value( bypassed or not, enabled or not)
     layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled", "Analyzer Enabled", true));     // Creating AudioParameterBool object. Represents a true/false parameter(like a toggle switch or on/off button)  false or true - defaul value( bypassed or not, enabled or not)
 
+    // coefficient smoothing: Off keeps the block-rate designer, the others ramp the parameters and redesign every N samples
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Smoothing", "Smoothing",
+                                                            juce::StringArray{ "Off", "16 Samples", "32 Samples", "64 Samples", "128 Samples" }, 0));
+
+    // linear phase: the same curve as a symmetric FIR kernel, no phase shift but kernel length / 2 samples of latency
+    layout.add(std::make_unique<juce::AudioParameterBool>("Linear Phase", "Linear Phase", false));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Linear Phase Length", "Linear Phase Length",
+                                                            juce::StringArray{ "8192", "16384", "32768", "65536" }, 1));
+
+    // ramps every band from the previous block's automation value to this block's over the block, see processFilters
+    layout.add(std::make_unique<juce::AudioParameterBool>("Sample Accurate Automation", "Sample Accurate Automation", false));
+
+    // oversampling around the IIR chain: keeps the peak and high cut close to their analog shapes up near Nyquist
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling",
+                                                            juce::StringArray{ "Off", "2x", "4x", "8x" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling Filter", "Oversampling Filter",
+                                                            juce::StringArray{ "Polyphase IIR", "Linear Phase FIR" }, 0));
+
+    // dynamic peak: above the threshold the band's level pulls Peak Gain down by (level - threshold) * (1 - 1 / ratio) dB
+    layout.add(std::make_unique<juce::AudioParameterBool>("Peak Dynamic", "Peak Dynamic", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>("Peak Sidechain", "Peak Sidechain", false));   // detect on the sidechain bus instead of the input
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Threshold", "Peak Threshold",
+                                                           juce::NormalisableRange<float>(-60.f, 0.f, 0.1f, 1.f), -24.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Ratio", "Peak Ratio",
+                                                           juce::NormalisableRange<float>(1.f, 20.f, 0.1f, 0.5f), 4.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Attack", "Peak Attack",
+                                                           juce::NormalisableRange<float>(0.1f, 100.f, 0.1f, 0.3f), 2.f));     // ms
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Release", "Peak Release",
+                                                           juce::NormalisableRange<float>(5.f, 1000.f, 1.f, 0.3f), 80.f));     // ms
+
+    // stereo mode: linked runs the bands above on both channels, mid/side and left/right give the second channel
+    // (side or right) its own bands below, same ranges and defaults as the first set
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Stereo Mode", "Stereo Mode",
+                                                            juce::StringArray{ "Stereo", "Mid/Side", "Left/Right" }, 0));
+
+    const auto& secondSet = bandParameterIDs[1];
+    layout.add(std::make_unique<juce::AudioParameterFloat>(secondSet.lowCutFreq, "Side/Right LowCut Freq",
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(secondSet.highCutFreq, "Side/Right HighCut Freq",
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20000.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(secondSet.peakFreq, "Side/Right Peak Freq",
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(secondSet.peakGain, "Side/Right Peak Gain",
+                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(secondSet.peakQuality, "Side/Right Peak Quality",
+                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(secondSet.lowCutSlope, "Side/Right LowCut Slope", stringArray, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(secondSet.highCutSlope, "Side/Right HighCut Slope", stringArray, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>(secondSet.lowCutBypassed, "Side/Right LowCut Bypassed", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(secondSet.peakBypassed, "Side/Right Peak Bypassed", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(secondSet.highCutBypassed, "Side/Right HighCut Bypassed", false));
+
     return layout;
 }
 
@@ -9,26 +9,66 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CoefficientDesigner.h"
+#include "SIMDFilterChain.h"
+#include "RealtimeSafetyAudit.h"
+#include "DSPLoadMeter.h"
+#include "SpectrumAnalyzer.h"
+#include "LinearPhaseEQ.h"
+#include "DynamicBand.h"
 enum Slope {
     Slope12, 
     Slope24, 
     Slope36,
     Slope48
 };
+enum StereoMode {   // same order as the "Stereo Mode" choices
+    stereoLinked,      // one set of bands for both channels
+    midSide,           // the bands run on mid and side, the second set is for the side
+    leftRight          // left and right each get their own bands
+};
 struct  ChainSettings
 {
     float peakFreq{ 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
     float lowCutFreq{ 0 }, highCutFreq{ 0 };
     Slope lowCutSlope{ Slope::Slope12 }, highCutSlope{ Slope::Slope12 };
+    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false };
+    bool peakDynamic{ false };   // the peak's gain follows its band's level (see DynamicBand)
 };
 
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);   // helperfunction that will give us all the parameters values in our data sctruct (above)
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts, int channelSet = 0);   // helperfunction that will give us all the parameters values in our data sctruct (above), set 1 is side or right
+StereoMode getStereoMode(juce::AudioProcessorValueTreeState& apvts);
+
+using BiquadCoefficients = std::array<double, 6>;   // b0, b1, b2, a0, a1, a2 - the plain array juce::dsp::IIR::ArrayCoefficients returns, no heap involved
+                                                    // always designed in double, a 20 Hz cut at 192 kHz puts its poles too close to 1 for float maths
+
+struct CutCoefficients
+{
+    std::array<BiquadCoefficients, 4> sections;   // one biquad per 12 db/Oct, Slope48 needs all four
+    int numSections{ 1 };
+};
+
+struct ChainCoefficients
+{
+    BiquadCoefficients peak;
+    CutCoefficients lowCut, highCut;
+    bool lowCutActive{ true }, peakActive{ true }, highCutActive{ true };   // inactive bands are left out of the per-sample loop
+};
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);   // designs every filter of the chain into plain arrays, no allocation involved
+double getButterworthSectionQ(int numSections, int section);   // Q of one biquad in a Butterworth cut made of numSections biquads
+void setActiveBands(ChainCoefficients& coefficients, const ChainSettings& chainSettings);   // works out which bands actually change the sound
+
+constexpr float silenceThreshold = 1.0e-7f;   // about -140 dB, below the last bit of 24 bit audio
+double getTailLengthSamples(const ChainCoefficients& coefficients);   // how long the active bands ring before decaying below silenceThreshold
 
 //==============================================================================
 /**
 */
-class NewProjectAudioProcessor  : public juce::AudioProcessor
+class NewProjectAudioProcessor  : public juce::AudioProcessor,
+                                  private juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::Timer
 {
 public:
     //==============================================================================
@@ -43,7 +83,21 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
+    // for the headless tools: main input and output get these channels, the sidechain stays disconnected;
+    // false if the layout isn't supported, the processor then keeps the layout it had
+    bool setMainBusLayout(const juce::AudioChannelSet& channels);
+
+    // message thread: applies a latched oversampling / linear-phase change and reports the latency, what the timer
+    // does every setupPollIntervalMs; the headless tools run no message loop and call it themselves
+    void applyPendingSetupChange();
+
+    // offline rendering, after prepareToPlay: blocks until the linear-phase kernel is in place (see LinearPhaseEQ),
+    // so the output doesn't depend on when the convolution's background thread gets round to it
+    bool waitUntilReadyToRender(int timeoutMilliseconds)   { return linearPhaseEQ.waitUntilKernelIsLoaded(timeoutMilliseconds); }
+
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override   { return true; }   // a 64 bit host mix runs the filters in double, no conversion
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -70,6 +124,17 @@ public:
     
 
 
+    // coefficient lookup tables, shared between instances at the same sample rate (see CoefficientCache)
+    void setCoefficientCacheEnabled(bool shouldUseCache) { coefficientDesigner.setCacheEnabled(shouldUseCache); }
+    bool isCoefficientCacheEnabled() const { return coefficientDesigner.isCacheEnabled(); }
+    size_t getCoefficientCacheMemoryUsage() const { return coefficientDesigner.getCacheMemoryUsageBytes(); }
+
+    // per-stage timings of processBlock, off until something (the editor, or EQ_DSP_LOAD_LOG) switches it on
+    DSPLoadMeter& getLoadMeter() noexcept { return loadMeter; }
+
+    // the one analysis product (spectrum and response curve) every open editor draws from, computed while any view is attached
+    SpectrumAnalyzer& getAnalyzer() noexcept { return analyzer; }
+
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
 
@@ -80,23 +145,44 @@ public:
    
 private:
 
-    using Filter = juce::dsp::IIR::Filter<float>;   //It is a digital filter class in the JUCE DSP module that processes audio by applying an IIR (Infinite Impulse Response) filter ( low-pass, high-pass etc)) to it
-    using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;  // slope of our cut filter, each of filters one octave ( loop from createParameterLayout()  method) 
-    using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
-    MonoChain leftChain, rightChain;    //before uning chains we need to prepare through prepareToPlay
+    // one chain per precision, the host decides which one runs (setProcessingPrecision before prepareToPlay)
+    SIMDFilterChain<float> floatChain;    //before uning the chain we need to prepare through prepareToPlay
+    SIMDFilterChain<double> doubleChain;
+
+    template <typename SampleType>
+    SIMDFilterChain<SampleType>& getFilterChain() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatChain;
+        else
+            return doubleChain;
+    }
 
-   /*            [leftChannel]                       [rightChannel]
-                        │                                   │
-        ┌───────────────┼───────────────┐     ┌─────────────┼──────────────┐
-        ▼                                   ▼
-       [CutFilter]  → [Filter]   →    [CutFilter]        [same]
-       (low cut)      (peak EQ)        (high cut)
-           │              │                 │
-       [F][F][F][F]      [F]            [F][F][F][F]
+    // optional oversampling around the IIR chain, so the bilinear transform cramps far above the audible range;
+    // the chain and the designer then run at the oversampled rate
+    std::unique_ptr<juce::dsp::Oversampling<float>> floatOversampler;
+    std::unique_ptr<juce::dsp::Oversampling<double>> doubleOversampler;
+    int oversamplingOrder = 0, oversamplingFilter = 0;   // what prepareToPlay set up, the audio thread never looks at the parameters for this
 
-       Where [F] is an instance of juce::dsp::IIR::Filter<float>
+    template <typename SampleType>
+    juce::dsp::Oversampling<SampleType>* getOversampler() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatOversampler.get();
+        else
+            return doubleOversampler.get();
+    }
 
-       ProcessorChain allows you to chain together multiple DSP modules (filters, compressors, etc.) in a clean and efficient way.
+   /*      [channel 0]   [channel 1]   [channel 2]   [channel 3]     [channel 4] ...
+                 │             │             │             │               │
+                 └──── interleaved into the lanes of one SIMDRegister ──────────┐      (next group of lanes, its own states)
+                                                                                  ▼
+                         [ low cut ]  → [ peak ]   →    [ high cut ]          one stage per band
+                          S  S  S  S       S            S  S  S  S            up to four biquad sections per stage
+
+       Where every S is one section of the chain's BiquadBank: its coefficients and its per-group states sit in
+       flat structure-of-arrays buffers, and all the sections of the stages that are on run as one cascade per
+       sample, every lane on its own channel, so up to four float channels cost a single pass (see SIMDFilterChain)
        */
 
 
@@ -105,6 +191,95 @@ private:
         Peak,
         HighCut
      };
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    bool readBinaryState(const void* data, int sizeInBytes);   // false if the data isn't in our binary format at all
+    std::atomic<bool> isRestoringState{ false };
+
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer);   // what both processBlock overloads do, timed when the load meter is on
+    template <typename SampleType>
+    void processBuffer(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType>
+    void processOversampled(juce::dsp::AudioBlock<SampleType>& block);   // the IIR path, with or without oversampling
+    template <typename SampleType>
+    void processFilters(juce::dsp::AudioBlock<SampleType>& block);
+    template <typename SampleType>
+    void processChains(juce::dsp::AudioBlock<SampleType>& block, int startSample = 0);   // runs the SIMD chain over every channel of the block, startSample is where block starts in the whole block
+    template <typename SampleType>
+    void processSmoothed(juce::dsp::AudioBlock<SampleType>& block, int subBlockSize, int rampLength = 0);   // rampLength 0: the usual smoothingRampSeconds
+    void resetSmoothers();   // jumps every channel set's ramps to the current parameters and designs them
+    void updateSmoothedCoefficients(int numSamples);   // advances the ramps, redesigns and applies the sets that are still moving
+
+    void applyCoefficients(const DesignedCoefficients& designed);   // points the chain at a coefficient set from the designer
+    void updateActiveStages(const DesignedCoefficients& designed);
+    template <typename SampleType>
+    static void applyCoefficients(SIMDFilterChain<SampleType>& chain, const DesignedCoefficients& designed, int numSets);
+
+    // mid/side runs the chain on M = (L + R) / 2 and S = (L - R) / 2 in the two channels, and turns them back afterwards
+    template <typename SampleType>
+    static void encodeMidSide(juce::dsp::AudioBlock<SampleType>& block) noexcept;
+    template <typename SampleType>
+    static void decodeMidSide(juce::dsp::AudioBlock<SampleType>& block) noexcept;
+    StereoMode stereoMode = stereoLinked;   // what the chains are running, follows the coefficient sets handed to them
+    bool canSplitChannels = false;          // only a stereo main bus has a mid/side or left/right to split
+
+    CoefficientDesigner coefficientDesigner{ apvts };   // designs coefficients off the audio thread whenever a parameter moves
+    SpectrumAnalyzer analyzer{ apvts };
+    LinearPhaseEQ linearPhaseEQ{ apvts };   // replaces the IIR chain while "Linear Phase" is on
+    DynamicBand dynamicBand{ apvts };       // turns the peak down as its band gets loud, IIR chain only
+    bool dynamicPeakThisBlock = false;      // the detector ran for this block, so the chain takes its peak sections from it
+    void restoreStaticPeak();               // puts the peak's own setting back into the chains when the dynamic mode stops
+    bool wasLinearPhase = false;
+    int silentInputSamples = 0;             // the linear-phase kernel keeps ringing for its whole length, not just until the output is quiet
+
+    // "Linear Phase", its length and the oversampling change the latency, and the oversampling the whole chain rate;
+    // parameterChanged latches that here and the timer applies it and reports the latency on the message thread
+    static constexpr int setupPollIntervalMs = 50;
+    std::atomic<bool> setupMayHaveChanged{ false };
+    bool isPrepared = false;   // between prepareToPlay and releaseResources
+
+    void timerCallback() override   { applyPendingSetupChange(); }
+    void prepareOversampled(double sampleRate, int samplesPerBlock);   // the oversamplers and everything that runs at the chain rate
+    void updateLatency();
+    const DesignedCoefficients* currentDesigned = nullptr;   // last set pulled from the designer
+
+    // smoothing mode: parameters ramp towards their targets and the chains get redesigned on the audio thread every sub-block
+    static constexpr double smoothingRampSeconds = 0.05;
+    std::atomic<float>* smoothingParameter = nullptr;
+    static constexpr int automationSubBlockSize = 32;   // how often sample accurate automation redesigns while "Smoothing" is off
+    std::atomic<float>* sampleAccurateParameter = nullptr;
+    bool wasSmoothing = false;
+
+    template <typename SampleType>
+    static bool isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels);
+    void resumeFromIdle();
+    bool isIdle = false;   // input is silent and the filters have rung out, so processBlock has nothing to do
+    DesignedCoefficients smoothedCoefficients;   // what the chains point at while smoothing, owned by the audio thread
+
+    // the ramps of one channel set
+    struct ChainSmoother
+    {
+        void prepare(double sampleRate);
+        void reset(const ChainSettings& chainSettings);      // jumps straight to these settings
+        void setTarget(const ChainSettings& chainSettings, int rampLength);  // slopes, bypasses and the dynamic switch change straight away, there is nothing to ramp
+        bool needsDesign() const noexcept;                   // still ramping, or something switched since the last skip()
+        ChainSettings skip(int numSamples);                  // advances the ramps, the settings they have reached
+
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> peakFreq, peakQuality, lowCutFreq, highCutFreq;
+        juce::SmoothedValue<float> peakGain;   // linear in dB
+        ChainSettings switched;                // the slopes and flags, the chain crossfades bypasses
+        bool hasSwitched = false;
+
+        void setRampLength(int numSamples);
+        int rampLength = 0, defaultRampLength = 0;   // in chain samples
+    };
+
+    std::array<ChainSmoother, DesignedCoefficients::maxChannelSets> smoothers;
+
+    DSPLoadMeter loadMeter;
+    DSPLoadMeter::BlockTimings blockTimings;   // the block being timed, audio thread only
    
 
     //==============================================================================
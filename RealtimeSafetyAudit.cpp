@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    This file contains the realtime safety audit: hooks that report every
+    allocation, lock and blocking call made inside processBlock.
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafetyAudit.h"
+
+#if EQ_REALTIME_AUDIT
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <time.h>
+ #include <unistd.h>
+
+ extern "C" void* __libc_malloc(size_t);
+ extern "C" void* __libc_calloc(size_t, size_t);
+ extern "C" void* __libc_realloc(void*, size_t);
+ extern "C" void __libc_free(void*);
+#endif
+
+namespace RealtimeSafetyAudit
+{
+    // plain zero initialised thread locals, safe to touch from inside malloc
+    static thread_local int realtimeDepth = 0;
+    static thread_local bool isReporting = false;
+
+    static std::atomic<int> numViolations{ 0 };
+    static std::atomic<bool> abortOnViolation{ false };
+
+    static bool shouldTrap() noexcept
+    {
+        return realtimeDepth > 0 && ! isReporting;
+    }
+
+    static void reportViolation(const char* what) noexcept
+    {
+        isReporting = true;   // printing the report allocates and locks itself
+
+        ++numViolations;
+        std::fprintf(stderr, "\n*** realtime violation: %s inside processBlock\n%s\n",
+                     what, juce::SystemStats::getStackBacktrace().toRawUTF8());
+
+        if (abortOnViolation.load())
+            std::abort();
+
+        isReporting = false;
+    }
+
+    ScopedRealtimeSection::ScopedRealtimeSection() noexcept    { ++realtimeDepth; }
+    ScopedRealtimeSection::~ScopedRealtimeSection() noexcept   { --realtimeDepth; }
+
+    int getNumViolations() noexcept                       { return numViolations.load(); }
+    void resetViolations() noexcept                       { numViolations = 0; }
+    void setAbortOnViolation(bool shouldAbort) noexcept   { abortOnViolation = shouldAbort; }
+}
+
+using RealtimeSafetyAudit::shouldTrap;
+using RealtimeSafetyAudit::reportViolation;
+
+//==============================================================================
+#if defined(__GLIBC__)
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        if (shouldTrap())
+            reportViolation("malloc");
+
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        if (shouldTrap())
+            reportViolation("calloc");
+
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        if (shouldTrap())
+            reportViolation("realloc");
+
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr && shouldTrap())
+            reportViolation("free");
+
+        __libc_free(pointer);
+    }
+}
+
+// the real functions are looked up lazily, a function local static would take a lock to initialise
+template <typename FunctionType>
+static FunctionType getNextFunction(std::atomic<FunctionType>& cached, const char* name) noexcept
+{
+    auto function = cached.load(std::memory_order_relaxed);
+
+    if (function == nullptr)
+    {
+        function = reinterpret_cast<FunctionType>(dlsym(RTLD_NEXT, name));
+        cached.store(function, std::memory_order_relaxed);
+    }
+
+    return function;
+}
+
+#define EQ_AUDIT_FORWARD(returnType, name, parameters, arguments)                          \
+    extern "C" returnType name parameters                                                  \
+    {                                                                                      \
+        static std::atomic<returnType (*) parameters> next{ nullptr };                     \
+                                                                                           \
+        if (shouldTrap())                                                                  \
+            reportViolation(#name);                                                        \
+                                                                                           \
+        return getNextFunction(next, #name) arguments;                                     \
+    }
+
+// the aligned allocations don't go through malloc, and aligned operator new (an over-aligned SIMDRegister vector
+// growing, say) ends up in one of these
+EQ_AUDIT_FORWARD(int, posix_memalign, (void** pointer, size_t alignment, size_t size), (pointer, alignment, size))
+EQ_AUDIT_FORWARD(void*, aligned_alloc, (size_t alignment, size_t size), (alignment, size))
+EQ_AUDIT_FORWARD(void*, memalign, (size_t alignment, size_t size), (alignment, size))
+
+EQ_AUDIT_FORWARD(int, pthread_mutex_lock, (pthread_mutex_t* mutex), (mutex))
+EQ_AUDIT_FORWARD(int, pthread_cond_wait, (pthread_cond_t* condition, pthread_mutex_t* mutex), (condition, mutex))
+EQ_AUDIT_FORWARD(int, pthread_cond_timedwait, (pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time), (condition, mutex, time))
+EQ_AUDIT_FORWARD(int, nanosleep, (const struct timespec* duration, struct timespec* remaining), (duration, remaining))
+EQ_AUDIT_FORWARD(int, usleep, (useconds_t microseconds), (microseconds))
+EQ_AUDIT_FORWARD(ssize_t, read, (int fd, void* buffer, size_t size), (fd, buffer, size))
+EQ_AUDIT_FORWARD(ssize_t, write, (int fd, const void* buffer, size_t size), (fd, buffer, size))
+
+#undef EQ_AUDIT_FORWARD
+
+//==============================================================================
+#else   // no malloc interposition here, catch what goes through the C++ allocator at least
+
+void* operator new(std::size_t size)
+{
+    if (shouldTrap())
+        reportViolation("operator new");
+
+    if (auto* pointer = std::malloc(size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr && shouldTrap())
+        reportViolation("operator delete");
+
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+#endif
+#endif
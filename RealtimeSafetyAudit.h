@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    This file contains the realtime safety audit: hooks that report every
+    allocation, lock and blocking call made inside processBlock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// build with EQ_REALTIME_AUDIT=1 to compile the hooks in, release builds leave it at 0 and pay nothing
+#ifndef EQ_REALTIME_AUDIT
+ #define EQ_REALTIME_AUDIT 0
+#endif
+
+//==============================================================================
+/**
+    While a ScopedRealtimeSection is alive on a thread, the audit build reports every call on that thread
+    that has no business in an audio callback, with a stack trace, and counts it as a violation.
+
+    - On Linux (glibc) malloc/calloc/realloc/free, the aligned allocators, pthread mutex locks and condition
+      waits, sleeps and read/write are interposed, so allocations inside JUCE containers and CriticalSections
+      are caught too.
+    - Elsewhere only C++ operator new/delete are replaced.
+
+    Interposing only works for code linked into the executable, so the audit runs in the console tools
+    (Tests/Main.cpp, which fails on any violation, and "EQBenchmarks --realtime-audit"), not inside a
+    host that dlopens the plugin. Neither has build files in this repository yet, see Tests/Main.cpp.
+*/
+namespace RealtimeSafetyAudit
+{
+    constexpr bool isEnabled = EQ_REALTIME_AUDIT != 0;
+
+   #if EQ_REALTIME_AUDIT
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+    };
+
+    int getNumViolations() noexcept;
+    void resetViolations() noexcept;
+    void setAbortOnViolation(bool shouldAbort) noexcept;   // stop at the first violation, handy under a debugger
+   #else
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection() noexcept {}
+    };
+
+    inline int getNumViolations() noexcept                { return 0; }
+    inline void resetViolations() noexcept                {}
+    inline void setAbortOnViolation(bool) noexcept        {}
+   #endif
+}
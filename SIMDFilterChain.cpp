@@ -0,0 +1,324 @@
+/*
+  ==============================================================================
+
+    This file contains the filter chain that runs several channels at once,
+    one channel per SIMD lane.
+
+  ==============================================================================
+*/
+
+#include "SIMDFilterChain.h"
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::prepare(double sampleRate, int maximumBlockSize, int newNumChannels, int numStagesToUse)
+{
+    numChannels = juce::jmax(1, newNumChannels);
+    numGroups = (int) (((size_t) numChannels + numLanes - 1) / numLanes);
+
+    // keep the stages' on/off state and section counts across a re-prepare, a new stage starts out as one flat section
+    stages.resize((size_t) juce::jmax(1, numStagesToUse));
+    bank.prepare((int) stages.size() * maxSectionsPerStage, numGroups);
+    sectionList.resize((size_t) bank.getMaximumNumSections());
+
+    interleaved = juce::dsp::AudioBlock<Register>(interleavedData, 1, (size_t) maximumBlockSize);
+    interleaved.clear();
+    dry = juce::dsp::AudioBlock<Register>(dryData, 1, (size_t) maximumBlockSize);
+
+    for (auto& stage : stages)
+    {
+        for (int set = 0; set < maxChannelSets; ++set)
+        {
+            stage.mix[(size_t) set].reset(sampleRate, fadeSeconds);
+            stage.mix[(size_t) set].setCurrentAndTargetValue(stage.active[(size_t) set] ? SampleType(1) : SampleType(0));
+        }
+
+        stage.gains.assign((size_t) maximumBlockSize, Register::expand(SampleType(1)));
+    }
+
+    // the bank starts out flat, so the sections of a second set have to be written again by the caller
+    numChannelSets = 1;
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::reset()
+{
+    bank.reset();
+}
+
+template <typename SampleType>
+size_t SIMDFilterChain<SampleType>::getLaneMask(int channelSet) const noexcept
+{
+    // channel n of a group sits in lane n, and channel n belongs to set n % numChannelSets
+    size_t mask = 0;
+
+    for (size_t lane = 0; lane < numLanes; ++lane)
+        if ((int) (lane % (size_t) numChannelSets) == channelSet)
+            mask |= (size_t) 1 << lane;
+
+    return mask;
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::setNumChannelSets(int numSets) noexcept
+{
+    numSets = juce::jlimit(1, maxChannelSets, numSets);
+    if (numSets == numChannelSets)
+        return;
+
+    if (numSets > numChannelSets)
+    {
+        // the second set carries on where the first one is, until it gets its own sections
+        for (auto& stage : stages)
+        {
+            stage.numSections[1] = stage.numSections[0];
+            stage.active[1] = stage.active[0];
+            stage.mix[1].setCurrentAndTargetValue(stage.mix[0].getCurrentValue());
+            stage.mix[1].setTargetValue(stage.mix[0].getTargetValue());
+        }
+    }
+
+    numChannelSets = numSets;
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::setStageSections(int stageIndex, const typename Bank::Coefficients* sections, int numSections, int channelSet) noexcept
+{
+    jassert(juce::isPositiveAndBelow(stageIndex, getNumStages()) && numSections > 0 && numSections <= maxSectionsPerStage);
+    jassert(channelSet == allChannelSets || juce::isPositiveAndBelow(channelSet, numChannelSets));
+
+    auto& stage = stages[(size_t) stageIndex];
+    const auto first = getFirstSection((size_t) stageIndex);
+    numSections = juce::jlimit(1, maxSectionsPerStage, numSections);
+
+    if (channelSet == allChannelSets)
+    {
+        stage.numSections.fill(numSections);
+
+        for (int i = 0; i < numSections; ++i)
+            bank.setSection(first + i, sections[i]);
+
+        return;
+    }
+
+    // only this set's lanes; the stage runs as many sections as the longer set needs, so the rest are made flat
+    stage.numSections[(size_t) channelSet] = numSections;
+    const auto laneMask = getLaneMask(channelSet);
+
+    for (int i = 0; i < maxSectionsPerStage; ++i)
+    {
+        if (i < numSections)
+            bank.setSection(first + i, sections[i], laneMask);
+        else
+            bank.setSectionFlat(first + i, laneMask);
+    }
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::setStageActive(int stageIndex, bool shouldBeActive, int channelSet) noexcept
+{
+    auto& stage = stages[(size_t) stageIndex];
+    const auto firstSet = channelSet == allChannelSets ? 0 : channelSet;
+    const auto lastSet = channelSet == allChannelSets ? numChannelSets : channelSet + 1;
+
+    for (int set = firstSet; set < lastSet; ++set)
+    {
+        const auto index = (size_t) set;
+        if (stage.active[index] == shouldBeActive)
+            continue;
+
+        // a stage coming back from being skipped would start from whatever state it was left in, clear that first
+        if (shouldBeActive && stage.mix[index].getCurrentValue() == SampleType(0))
+            bank.resetSections(getFirstSection((size_t) stageIndex), maxSectionsPerStage, getLaneMask(set));
+
+        stage.active[index] = shouldBeActive;
+        stage.mix[index].setTargetValue(shouldBeActive ? SampleType(1) : SampleType(0));
+    }
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::skipFades() noexcept
+{
+    for (auto& stage : stages)
+        for (int set = 0; set < maxChannelSets; ++set)
+            stage.mix[(size_t) set].setCurrentAndTargetValue(stage.active[(size_t) set] ? SampleType(1) : SampleType(0));
+}
+
+template <typename SampleType>
+bool SIMDFilterChain<SampleType>::hasRungOut(SampleType threshold) const noexcept
+{
+    // a skipped stage holds on to stale state, but that is cleared before it runs again (see setStageActive)
+    for (size_t stage = 0; stage < stages.size(); ++stage)
+        if (stages[stage].runsThisBlock && ! bank.isSilent(getFirstSection(stage), stages[stage].numSectionsThisBlock, threshold))
+            return false;
+
+    return true;
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::prepareStage(StageState& stage, size_t numSamples) noexcept
+{
+    auto anySmoothing = false, anyActive = false, allActive = true;
+    auto numSectionsToRun = 1;
+
+    for (int set = 0; set < numChannelSets; ++set)
+    {
+        const auto index = (size_t) set;
+        anySmoothing = anySmoothing || stage.mix[index].isSmoothing();
+        anyActive = anyActive || stage.active[index];
+        allActive = allActive && stage.active[index];
+        numSectionsToRun = juce::jmax(numSectionsToRun, stage.numSections[index]);
+    }
+
+    stage.numSectionsThisBlock = numSectionsToRun;
+    stage.runsThisBlock = anySmoothing || anyActive;
+    stage.blockGains = nullptr;
+
+    if (! anySmoothing && (allActive || ! anyActive))
+        return;
+
+    // fading, or in for one set and out for the other: every lane gets its own set's mix
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        std::array<SampleType, maxChannelSets> values{};
+
+        for (int set = 0; set < numChannelSets; ++set)
+            values[(size_t) set] = stage.mix[(size_t) set].getNextValue();
+
+        auto& gain = stage.gains[i];
+        for (size_t lane = 0; lane < numLanes; ++lane)
+            gain.set(lane, values[lane % (size_t) numChannelSets]);
+    }
+
+    stage.blockGains = stage.gains.data();
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::appendSections(size_t stage, int*& list) const noexcept
+{
+    const auto first = getFirstSection(stage);
+
+    for (int i = 0; i < stages[stage].numSectionsThisBlock; ++i)
+        *list++ = first + i;
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::processStage(size_t stage, size_t group, Register* samples, size_t numSamples) noexcept
+{
+    auto* list = sectionList.data();
+    appendSections(stage, list);
+    const auto numSections = (int) (list - sectionList.data());
+
+    const auto* gains = stages[stage].blockGains;
+
+    if (gains == nullptr)
+    {
+        bank.process(samples, numSamples, group, sectionList.data(), numSections);
+        return;
+    }
+
+    auto* input = dry.getChannelPointer(0);
+    std::copy(samples, samples + numSamples, input);
+
+    bank.process(samples, numSamples, group, sectionList.data(), numSections);
+
+    for (size_t i = 0; i < numSamples; ++i)
+        samples[i] = input[i] + (samples[i] - input[i]) * gains[i];
+}
+
+template <typename SampleType>
+void SIMDFilterChain<SampleType>::process(juce::dsp::AudioBlock<SampleType>& block, juce::int64* stageTicks) noexcept
+{
+    const auto numChannelsToProcess = juce::jmin(block.getNumChannels(), (size_t) numChannels);
+    const auto numSamples = block.getNumSamples();
+    jassert(numSamples <= interleaved.getNumSamples());
+
+    // work out once per block how each stage runs, every group has to follow the same fade
+    auto anyStageRuns = false;
+
+    for (auto& stage : stages)
+    {
+        prepareStage(stage, numSamples);
+        anyStageRuns = anyStageRuns || stage.runsThisBlock;
+    }
+
+    if (! anyStageRuns)
+        return;   // every band is bypassed or flat, the output is the input
+
+    auto simdBlock = interleaved.getSubBlock(0, numSamples);
+    auto* samples = simdBlock.getChannelPointer(0);
+    auto* lanes = reinterpret_cast<SampleType*>(samples);   // a SIMDRegister is laid out as numLanes plain samples
+
+    for (size_t group = 0, firstChannel = 0; firstChannel < numChannelsToProcess; ++group, firstChannel += numLanes)
+    {
+        const auto numChannelsInGroup = juce::jmin(numLanes, numChannelsToProcess - firstChannel);
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            if (lane < numChannelsInGroup)
+            {
+                const auto* source = block.getChannelPointer(firstChannel + lane);
+                for (size_t i = 0; i < numSamples; ++i)
+                    lanes[i * numLanes + lane] = source[i];
+            }
+            else
+            {
+                for (size_t i = 0; i < numSamples; ++i)   // lanes without a channel stay silent, so they never produce denormals or NaNs
+                    lanes[i * numLanes + lane] = SampleType(0);
+            }
+        }
+
+        if (stageTicks == nullptr)
+        {
+            // consecutive stages that are fully in go through the bank as one cascade, a fading stage needs its own
+            // pass because its output is mixed with its input
+            auto* list = sectionList.data();
+
+            auto flush = [&]
+            {
+                bank.process(samples, numSamples, group, sectionList.data(), (int) (list - sectionList.data()));
+                list = sectionList.data();
+            };
+
+            for (size_t stage = 0; stage < stages.size(); ++stage)
+            {
+                if (! stages[stage].runsThisBlock)
+                    continue;
+
+                if (stages[stage].blockGains == nullptr)
+                {
+                    appendSections(stage, list);
+                    continue;
+                }
+
+                flush();
+                processStage(stage, group, samples, numSamples);
+            }
+
+            flush();
+        }
+        else
+        {
+            // same thing one stage at a time, with the time each stage takes added to stageTicks
+            for (size_t stage = 0; stage < stages.size(); ++stage)
+            {
+                if (! stages[stage].runsThisBlock)
+                    continue;
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                processStage(stage, group, samples, numSamples);
+                stageTicks[stage] += juce::Time::getHighResolutionTicks() - start;
+            }
+        }
+
+        for (size_t lane = 0; lane < numChannelsInGroup; ++lane)
+        {
+            auto* destination = block.getChannelPointer(firstChannel + lane);
+            for (size_t i = 0; i < numSamples; ++i)
+                destination[i] = lanes[i * numLanes + lane];
+        }
+    }
+}
+
+//==============================================================================
+template class SIMDFilterChain<float>;
+template class SIMDFilterChain<double>;
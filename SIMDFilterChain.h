@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    This file contains the filter chain that runs several channels at once,
+    one channel per SIMD lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadBank.h"
+
+//==============================================================================
+/**
+    The EQ's filters, built from a BiquadBank, for any number of channels and any number of stages.
+
+    Channels are taken numLanes at a time (4 floats or 2 doubles with SSE/NEON), interleaved into SIMDRegister lanes,
+    run through the cascade and de-interleaved again, so stereo costs one pass over the biquads instead of two
+    and a 7.1.4 bus costs three. By default every channel runs the same coefficients, so a set is designed and
+    stored once for all channels. With setNumChannelSets(2) the even and odd channels (left/right, or mid/side)
+    get their own settings, still in the same pass: only the lanes of that channel set are written.
+
+    A stage is one band of the EQ: up to maxSectionsPerStage biquads (a 48 dB/Oct cut needs four, a bell one),
+    set with setStageSections(). prepare() takes the number of stages, the default is the LowCut -> Peak -> HighCut
+    layout, and the cost only grows with the sections of the stages that are actually on.
+
+    Each lane runs the exact same transposed direct form II arithmetic as the scalar IIR::Filter<SampleType>, so
+    the output is bit-identical to the scalar chain, with one exception: the scalar filter flushes state values
+    below 1e-8 to zero at the end of every block and this one doesn't. That only matters for signals
+    decaying into the -160 dB region and keeps the difference below 1e-7 absolute. Tests/FilterChainTests.cpp
+    holds it to that, sample for sample against IIR::Filter::processSample.
+
+    Stages that are switched off with setStageActive() are skipped entirely rather than run with flat
+    coefficients. Switching a stage on or off crossfades between its input and its output over fadeSeconds, so
+    there is no click, and once every stage is off process() returns without touching the audio. All stages that
+    are fully in run as a single cascade, only a stage that is fading (or on for one channel set and off for the
+    other) is run on its own.
+*/
+template <typename SampleType>
+class SIMDFilterChain
+{
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    using Bank = BiquadBank<SampleType>;
+
+    static constexpr size_t numLanes = Register::SIMDNumElements;
+    static constexpr int maxSectionsPerStage = 4;
+    static constexpr int maxChannelSets = 2, allChannelSets = -1;
+
+    enum Stage { lowCutStage, peakStage, highCutStage, numStages };   // the default layout, in chain order
+
+    // channel n of a group belongs to set n % numChannelSets through its lane alone (see getLaneMask), so the sets
+    // have to divide the lanes evenly; juce::dsp::SIMDRegister has at least two lanes on every target it supports
+    static_assert(numLanes % (size_t) maxChannelSets == 0, "every group has to hold whole pairs of channels");
+
+    static_assert(numStages * maxSectionsPerStage <= (int) Bank::maxUnrolledSections,
+                  "the default chain should never be split across two cascade kernels");
+
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels, int numStagesToUse = numStages);
+    void reset();
+
+    // processes up to the prepared number of channels in place, if stageTicks points at one counter per stage the
+    // high resolution ticks spent in each stage are added to them (the stages then run one at a time)
+    void process(juce::dsp::AudioBlock<SampleType>& block, juce::int64* stageTicks = nullptr) noexcept;
+
+    // audio thread: 1 = every channel runs channel set 0, 2 = even channels run set 0 and odd channels set 1;
+    // a new second set starts out as a copy of the first one
+    void setNumChannelSets(int numSets) noexcept;
+    int getNumChannelSets() const noexcept      { return numChannelSets; }
+
+    // audio thread, no allocation: the stage runs these sections from the next block on, in every channel set or just one
+    void setStageSections(int stage, const typename Bank::Coefficients* sections, int numSections, int channelSet = allChannelSets) noexcept;
+
+    // audio thread, starts a crossfade when the state changes
+    void setStageActive(int stage, bool shouldBeActive, int channelSet = allChannelSets) noexcept;
+    void skipFades() noexcept;   // jumps every stage straight to its current state
+
+    // true when the state of every stage that ran in the last block is below threshold, so it has rung out:
+    // the output can be quiet while a low, resonant band still holds energy that would come back as a click
+    bool hasRungOut(SampleType threshold) const noexcept;
+
+    int getNumChannels() const noexcept         { return numChannels; }
+    int getNumStages() const noexcept           { return (int) stages.size(); }
+
+private:
+    static constexpr double fadeSeconds = 0.01;
+
+    struct StageState
+    {
+        std::array<int, maxChannelSets> numSections{ 1, 1 };
+        std::array<bool, maxChannelSets> active{ true, true };
+        std::array<juce::SmoothedValue<SampleType>, maxChannelSets> mix;   // 0 = stage skipped, 1 = stage fully in
+        std::vector<Register> gains;   // this block's mix per sample and lane, shared by every group
+
+        bool runsThisBlock = false;
+        const Register* blockGains = nullptr;   // points at gains while mixing, nullptr while fully in
+        int numSectionsThisBlock = 1;
+    };
+
+    int getFirstSection(size_t stage) const noexcept   { return (int) stage * maxSectionsPerStage; }
+    size_t getLaneMask(int channelSet) const noexcept;
+    void prepareStage(StageState& stage, size_t numSamples) noexcept;
+    void appendSections(size_t stage, int*& list) const noexcept;
+    void processStage(size_t stage, size_t group, Register* samples, size_t numSamples) noexcept;
+
+    Bank bank;
+    int numChannels = 0, numGroups = 0, numChannelSets = 1;
+    std::vector<StageState> stages;
+    std::vector<int> sectionList;   // the bank sections of the stages run in one go
+
+    juce::HeapBlock<char> interleavedData, dryData;
+    juce::dsp::AudioBlock<Register> interleaved;   // scratch for one group: one sample per SIMDRegister, one lane per channel
+    juce::dsp::AudioBlock<Register> dry;           // a stage's input while it is crossfading
+};
@@ -0,0 +1,335 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyzer: the audio thread taps the signal
+    before and after the EQ, a background thread turns it, together with the
+    chain's frequency response, into one analysis product every editor reads.
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+#include "PluginProcessor.h"
+
+SpectrumAnalyzer::SpectrumAnalyzer(juce::AudioProcessorValueTreeState& apvtsToUse)
+    : apvts(apvtsToUse),
+      enabledParameter(apvts.getRawParameterValue("Analyzer Enabled"))
+{
+    jassert(enabledParameter != nullptr);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    const juce::ScopedLock lock(registrationLock);
+
+    if (isRegistered)
+        analyzerThread->removeTimeSliceClient(this);
+}
+
+void SpectrumAnalyzer::prepare(double newSampleRate, double newChainSampleRate)
+{
+    const juce::ScopedLock lock(registrationLock);
+
+    if (isRegistered)
+        analyzerThread->removeTimeSliceClient(this);   // waits for a slice in progress, the thread state is ours after this
+
+    sampleRate = newSampleRate;
+    chainSampleRate = newChainSampleRate;
+    wasActive = false;         // the next active slice reconfigures the FFTs for the new rate
+    cosines.clear();           // and the response is recomputed on new frequency tables
+    framePending = true;
+
+    if (isRegistered)
+        analyzerThread->addTimeSliceClient(this);
+}
+
+void SpectrumAnalyzer::addView()
+{
+    const juce::ScopedLock lock(registrationLock);
+
+    if (++numViews == 1 && ! isRegistered)
+    {
+        analyzerThread->addTimeSliceClient(this);
+        isRegistered = true;
+    }
+}
+
+void SpectrumAnalyzer::removeView()
+{
+    const juce::ScopedLock lock(registrationLock);
+    jassert(numViews > 0);
+
+    if (--numViews == 0 && isRegistered)
+    {
+        analyzerThread->removeTimeSliceClient(this);   // last editor closed, no more analysis for this instance
+        isRegistered = false;
+    }
+}
+
+//==============================================================================
+int SpectrumAnalyzer::useTimeSlice()
+{
+    const auto version = requestedResponseVersion.load(std::memory_order_acquire);
+
+    if (version != responseDesignedVersion || cosines.empty())
+    {
+        responseDesignedVersion = version;
+        updateResponse();
+        framePending = true;
+    }
+
+    const auto spectrumIsActive = isActive();
+
+    if (spectrumIsActive)
+    {
+        const auto order = fftOrder.load(std::memory_order_relaxed);
+
+        if (! wasActive || order != currentOrder)
+        {
+            configure(order);
+            wasActive = true;
+        }
+
+        const auto fftSize = 1 << currentOrder;
+        const auto hopSeconds = (float) (fftSize / overlap) / (float) sampleRate;
+        const auto seconds = averagingSeconds.load(std::memory_order_relaxed);
+        const auto averagingCoefficient = seconds > 0.0f ? std::exp(-hopSeconds / seconds) : 0.0f;
+        const auto holdDecayPerFrame = peakHoldDecay.load(std::memory_order_relaxed) * hopSeconds;
+
+        for (auto tap : { preEQ, postEQ })
+            framePending = processTap(tap, averagingCoefficient, holdDecayPerFrame) || framePending;
+    }
+    else if (wasActive)
+    {
+        wasActive = false;     // parameter switched off, views get one more frame without a spectrum
+        framePending = true;
+    }
+
+    if (framePending)
+        framePending = ! publishFrame();   // every spare slot pinned by a view, try again next slice
+
+    return spectrumIsActive || framePending ? activeIntervalMs : idleIntervalMs;
+}
+
+bool SpectrumAnalyzer::publishFrame()
+{
+    auto* frame = frames.beginWrite();
+    if (frame == nullptr)
+        return false;
+
+    frame->responseVersion = responseVersion;
+    frame->hasSpectrum = wasActive;
+
+    for (size_t tap = 0; tap < numTaps; ++tap)
+    {
+        if (wasActive)
+        {
+            buildPath(frame->average[tap], taps[tap].average);
+            buildPath(frame->peakHold[tap], taps[tap].peakHold);
+        }
+        else
+        {
+            frame->average[tap].clear();
+            frame->peakHold[tap].clear();
+        }
+    }
+
+    // the response is stored as complex values per point, the paths are made here so a view only has to stroke them
+    frame->magnitude.clear();
+    frame->phase.clear();
+
+    for (size_t point = 0; point < responseReal.size(); ++point)
+    {
+        const auto x = (float) point / (float) (numResponsePoints - 1);
+        const auto magnitude = std::sqrt(responseReal[point] * responseReal[point] + responseImag[point] * responseImag[point]);
+        const auto decibels = juce::jlimit(-responseRangeInDecibels, responseRangeInDecibels,
+                                           juce::Decibels::gainToDecibels(magnitude, -responseRangeInDecibels));
+        const auto magnitudeY = (float) juce::jmap(decibels, -responseRangeInDecibels, responseRangeInDecibels, 1.0, 0.0);
+        const auto phaseY = (float) juce::jmap(std::atan2(responseImag[point], responseReal[point]),
+                                               -juce::MathConstants<double>::pi, juce::MathConstants<double>::pi, 1.0, 0.0);
+
+        if (point == 0)
+        {
+            frame->magnitude.startNewSubPath(x, magnitudeY);
+            frame->phase.startNewSubPath(x, phaseY);
+        }
+        else
+        {
+            frame->magnitude.lineTo(x, magnitudeY);
+            frame->phase.lineTo(x, phaseY);
+        }
+    }
+
+    frames.publish();
+    return true;
+}
+
+//==============================================================================
+void SpectrumAnalyzer::updateFrequencyTables()
+{
+    for (auto* table : { &cosines, &cosines2, &sines, &sines2, &responseReal, &responseImag })
+        table->resize((size_t) numResponsePoints);
+
+    for (size_t point = 0; point < (size_t) numResponsePoints; ++point)
+    {
+        const auto frequency = minFrequency * std::pow((double) maxFrequency / minFrequency, (double) point / (numResponsePoints - 1));
+        const auto w = juce::MathConstants<double>::twoPi * frequency / chainSampleRate;
+        cosines[point] = std::cos(w);
+        cosines2[point] = std::cos(2.0 * w);
+        sines[point] = std::sin(w);
+        sines2[point] = std::sin(2.0 * w);
+    }
+}
+
+void SpectrumAnalyzer::updateResponse()
+{
+    if (cosines.empty())
+        updateFrequencyTables();
+
+    // the same design the processor runs, straight from the parameters, so the curve never lags behind the designer thread
+    const auto chainSettings = getChainSettings(apvts);
+    auto coefficients = makeChainCoefficients(chainSettings, chainSampleRate);
+    setActiveBands(coefficients, chainSettings);
+
+    const auto numColumns = cosines.size();
+    std::fill(responseReal.begin(), responseReal.end(), 1.0);
+    std::fill(responseImag.begin(), responseImag.end(), 0.0);
+
+    // H(e^jw) = (b0 + b1 e^-jw + b2 e^-2jw) / (a0 + a1 e^-jw + a2 e^-2jw), multiplied into the running response
+    // one biquad at a time over plain arrays, so the loop body has no branches and the compiler vectorises it
+    auto applySection = [&](const BiquadCoefficients& c)
+    {
+        const auto* cos1 = cosines.data();
+        const auto* cos2 = cosines2.data();
+        const auto* sin1 = sines.data();
+        const auto* sin2 = sines2.data();
+        auto* real = responseReal.data();
+        auto* imag = responseImag.data();
+
+        for (size_t x = 0; x < numColumns; ++x)
+        {
+            const auto numeratorReal = c[0] + c[1] * cos1[x] + c[2] * cos2[x];
+            const auto numeratorImag = -(c[1] * sin1[x] + c[2] * sin2[x]);
+            const auto denominatorReal = c[3] + c[4] * cos1[x] + c[5] * cos2[x];
+            const auto denominatorImag = -(c[4] * sin1[x] + c[5] * sin2[x]);
+
+            // numerator * conj(denominator) / |denominator|^2
+            const auto scale = 1.0 / (denominatorReal * denominatorReal + denominatorImag * denominatorImag);
+            const auto sectionReal = (numeratorReal * denominatorReal + numeratorImag * denominatorImag) * scale;
+            const auto sectionImag = (numeratorImag * denominatorReal - numeratorReal * denominatorImag) * scale;
+
+            const auto newReal = real[x] * sectionReal - imag[x] * sectionImag;
+            imag[x] = real[x] * sectionImag + imag[x] * sectionReal;
+            real[x] = newReal;
+        }
+    };
+
+    if (coefficients.lowCutActive)
+        for (int i = 0; i < coefficients.lowCut.numSections; ++i)
+            applySection(coefficients.lowCut.sections[(size_t) i]);
+
+    if (coefficients.peakActive)
+        applySection(coefficients.peak);
+
+    if (coefficients.highCutActive)
+        for (int i = 0; i < coefficients.highCut.numSections; ++i)
+            applySection(coefficients.highCut.sections[(size_t) i]);
+
+    ++responseVersion;
+}
+
+//==============================================================================
+void SpectrumAnalyzer::configure(int order)
+{
+    currentOrder = order;
+    const auto fftSize = 1 << order;
+    const auto numBins = fftSize / 2 + 1;
+
+    fft = std::make_unique<juce::dsp::FFT>(order);
+    window = std::make_unique<juce::dsp::WindowingFunction<float>>((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann);
+    fftData.assign((size_t) fftSize * 2, 0.0f);   // performFrequencyOnlyForwardTransform needs twice the size
+
+    for (auto& state : taps)
+    {
+        state.fifo.read(state.fifo.getNumReady());   // whatever is left from before we were switched off is stale
+        state.history.assign((size_t) fftSize, 0.0f);
+        state.average.assign((size_t) numBins, minDecibels);
+        state.peakHold.assign((size_t) numBins, minDecibels);
+    }
+
+    // each path point takes the loudest bin between its neighbours, so narrow peaks in the top octaves don't vanish
+    const auto binWidth = sampleRate / fftSize;
+    pointBins.resize((size_t) numPoints);
+
+    auto frequencyAt = [](double point)
+    {
+        return minFrequency * std::pow((double) maxFrequency / minFrequency, point / (numPoints - 1));
+    };
+
+    for (int point = 0; point < numPoints; ++point)
+    {
+        const auto first = juce::jlimit(1, numBins - 1, (int) std::floor(frequencyAt(point - 0.5) / binWidth));
+        const auto last = juce::jlimit(first, numBins - 1, (int) std::ceil(frequencyAt(point + 0.5) / binWidth));
+        pointBins[(size_t) point] = { first, last };
+    }
+}
+
+bool SpectrumAnalyzer::processTap(Tap tap, float averagingCoefficient, float holdDecayPerFrame)
+{
+    auto& state = taps[(size_t) tap];
+    const auto fftSize = (int) state.history.size();
+    const auto hopSize = fftSize / overlap;
+    auto anythingNew = false;
+
+    while (state.fifo.getNumReady() >= hopSize)
+    {
+        // slide the history along by one hop and append the new samples
+        std::move(state.history.begin() + hopSize, state.history.end(), state.history.begin());
+        auto* destination = state.history.data() + fftSize - hopSize;
+
+        const auto scope = state.fifo.read(hopSize);
+        std::copy_n(state.fifoData.data() + scope.startIndex1, scope.blockSize1, destination);
+        std::copy_n(state.fifoData.data() + scope.startIndex2, scope.blockSize2, destination + scope.blockSize1);
+
+        std::copy(state.history.begin(), state.history.end(), fftData.begin());
+        window->multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+        fft->performFrequencyOnlyForwardTransform(fftData.data());
+
+        // the window is normalised to unit mean, so a full scale sine peaks at fftSize / 2, which is 0 dB here
+        const auto magnitudeScale = 2.0f / (float) fftSize;
+
+        for (size_t bin = 0; bin < state.average.size(); ++bin)
+        {
+            const auto decibels = juce::Decibels::gainToDecibels(fftData[bin] * magnitudeScale, minDecibels);
+            auto& average = state.average[bin];
+            average = averagingCoefficient * average + (1.0f - averagingCoefficient) * decibels;
+            state.peakHold[bin] = juce::jmax(average, state.peakHold[bin] - holdDecayPerFrame);
+        }
+
+        anythingNew = true;
+    }
+
+    return anythingNew;
+}
+
+void SpectrumAnalyzer::buildPath(juce::Path& path, const std::vector<float>& decibels) const
+{
+    path.clear();   // keeps its storage, so once every slot has been used this doesn't allocate
+
+    for (int point = 0; point < numPoints; ++point)
+    {
+        const auto [first, last] = pointBins[(size_t) point];
+        auto level = minDecibels;
+
+        for (auto bin = first; bin <= last; ++bin)
+            level = juce::jmax(level, decibels[(size_t) bin]);
+
+        const auto x = (float) point / (float) (numPoints - 1);
+        const auto y = juce::jmap(juce::jlimit(minDecibels, maxDecibels, level), minDecibels, maxDecibels, 1.0f, 0.0f);
+
+        if (point == 0)
+            path.startNewSubPath(x, y);
+        else
+            path.lineTo(x, y);
+    }
+}
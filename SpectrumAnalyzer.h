@@ -0,0 +1,265 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyzer: the audio thread taps the signal
+    before and after the EQ, a background thread turns it, together with the
+    chain's frequency response, into one analysis product every editor reads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Wait-free single writer / many readers pool of immutable snapshots.
+
+    The writer fills a slot that is neither the latest one nor held by a reader, then publishes it, which makes it
+    the latest and bumps the sequence counter. Readers pin the latest slot with a ReadHandle and read it in place,
+    without copying, for as long as they hold the handle. A pinned slot is never written, so the writer only ever
+    skips a frame when every spare slot is pinned, and neither side ever waits for the other.
+*/
+template <typename FrameType, int numSlots = 8>
+class SnapshotPool
+{
+    struct Slot
+    {
+        FrameType frame;
+        std::atomic<int> numReaders{ 0 };
+    };
+
+public:
+    class ReadHandle
+    {
+    public:
+        ReadHandle() = default;
+        ReadHandle(ReadHandle&& other) noexcept : slot(std::exchange(other.slot, nullptr)) {}
+        ~ReadHandle()                                     { if (slot != nullptr) slot->numReaders.fetch_sub(1); }
+
+        const FrameType* operator->() const noexcept      { return &slot->frame; }
+        const FrameType& operator*() const noexcept       { return slot->frame; }
+        explicit operator bool() const noexcept           { return slot != nullptr; }
+
+    private:
+        friend class SnapshotPool;
+        explicit ReadHandle(Slot& slotToPin) noexcept : slot(&slotToPin) {}
+
+        Slot* slot = nullptr;
+
+        JUCE_DECLARE_NON_COPYABLE(ReadHandle)
+    };
+
+    ReadHandle acquireLatest() const noexcept   // any thread, an empty handle until the first publish()
+    {
+        for (;;)
+        {
+            const auto index = latest.load();
+            if (index < 0)
+                return {};
+
+            auto& slot = slots[(size_t) index];
+            slot.numReaders.fetch_add(1);
+
+            // still the latest after pinning it, so the writer can no longer pick it
+            if (latest.load() == index)
+                return ReadHandle(slot);
+
+            slot.numReaders.fetch_sub(1);
+        }
+    }
+
+    FrameType* beginWrite() noexcept   // writer only, nullptr when every spare slot is pinned by a reader
+    {
+        const auto current = latest.load();
+
+        for (int i = 0; i < numSlots; ++i)
+        {
+            if (i != current && slots[(size_t) i].numReaders.load() == 0)
+            {
+                writeIndex = i;
+                return &slots[(size_t) i].frame;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void publish() noexcept   // writer only, after a successful beginWrite()
+    {
+        jassert(writeIndex >= 0);
+        latest.store(std::exchange(writeIndex, -1));
+        sequence.fetch_add(1);
+    }
+
+    juce::uint64 getSequence() const noexcept   { return sequence.load(); }   // cheap check for "anything new?"
+
+private:
+    mutable std::array<Slot, (size_t) numSlots> slots;
+    std::atomic<int> latest{ -1 };
+    int writeIndex = -1;
+    std::atomic<juce::uint64> sequence{ 0 };
+};
+
+//==============================================================================
+/**
+    Pre/post EQ spectrum analyzer and frequency response, computed once per processor for any number of editors.
+
+    The audio thread mixes each tap down to mono and writes it into a wait-free AbstractFifo with pushSamples(),
+    a block that doesn't fit is simply dropped, so the callback never waits for the analyzer. A shared background
+    thread reads the FIFOs, runs Hann windowed FFTs every fftSize / overlap samples, keeps an exponential average
+    and a decaying peak hold per bin, recomputes the chain's response when a parameter moved, and publishes all of
+    it as one Frame of ready-to-draw paths into a SnapshotPool that every open editor reads in place.
+
+    The paths live in a unit square: x runs logarithmically from minFrequency to maxFrequency, y from the top of the
+    range (0) to the bottom (1), so a view only has to scale them to its bounds.
+
+    Nothing runs unless a view is attached (addView): the background thread is only registered while an editor is
+    open, and the FFTs and audio thread taps additionally need the "Analyzer Enabled" parameter. More views add no
+    analysis work, only their own painting.
+*/
+class SpectrumAnalyzer  : private juce::TimeSliceClient
+{
+public:
+    enum Tap { preEQ, postEQ, numTaps };
+
+    struct Frame
+    {
+        juce::uint64 responseVersion = 0;         // bumped whenever magnitude/phase changed, views cache their rendering on it
+        bool hasSpectrum = false;                 // false while the analyzer parameter is off
+        std::array<juce::Path, numTaps> average, peakHold;
+        juce::Path magnitude, phase;              // y spans +-responseRangeInDecibels and +-pi
+    };
+
+    using FramePool = SnapshotPool<Frame>;
+
+    static constexpr int minFFTOrder = 11, maxFFTOrder = 14;   // 2048 to 16384 points
+    static constexpr int overlap = 4;                          // a new FFT every fftSize / 4 samples
+    static constexpr float minFrequency = 20.0f, maxFrequency = 20000.0f;
+    static constexpr float minDecibels = -96.0f, maxDecibels = 6.0f;
+    static constexpr double responseRangeInDecibels = 24.0;
+
+    explicit SpectrumAnalyzer(juce::AudioProcessorValueTreeState& apvts);
+    ~SpectrumAnalyzer() override;
+
+    // the spectrum runs at the host rate, the response is evaluated for biquads designed at the chain's own rate,
+    // which is higher when the chain is oversampled
+    void prepare(double sampleRate, double chainSampleRate);
+
+    // audio thread, one check per block decides whether the taps run at all
+    bool isActive() const noexcept
+    {
+        return numViews.load(std::memory_order_relaxed) > 0 && enabledParameter->load(std::memory_order_relaxed) > 0.5f;
+    }
+
+    template <typename SampleType>
+    void pushSamples(Tap tap, const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+    void parametersChanged() noexcept     { requestedResponseVersion.fetch_add(1, std::memory_order_release); }   // any thread
+
+    // message thread, the analyzer thread only runs for this instance while at least one view is attached
+    void addView();
+    void removeView();
+
+    // any thread, the analyzer thread picks the new settings up before its next FFT
+    void setFFTOrder(int order) noexcept                  { fftOrder = juce::jlimit(minFFTOrder, maxFFTOrder, order); }
+    void setAveragingSeconds(float seconds) noexcept      { averagingSeconds = juce::jmax(0.0f, seconds); }
+    void setPeakHoldDecay(float decibelsPerSecond) noexcept { peakHoldDecay = juce::jmax(0.0f, decibelsPerSecond); }
+
+    // any number of views, any thread: getSequence() changes with every new frame, the handle pins it while drawing
+    juce::uint64 getSequence() const noexcept             { return frames.getSequence(); }
+    FramePool::ReadHandle acquireLatest() const noexcept  { return frames.acquireLatest(); }
+
+private:
+    int useTimeSlice() override;
+    void configure(int order);                  // analyzer thread, (re)allocates for a new FFT size and starts from scratch
+    bool processTap(Tap tap, float averagingCoefficient, float holdDecayPerFrame);
+    void updateFrequencyTables();
+    void updateResponse();
+    bool publishFrame();
+    void buildPath(juce::Path& path, const std::vector<float>& decibels) const;
+
+    struct AnalyzerThread  : juce::TimeSliceThread   // one thread shared by every instance in the process
+    {
+        AnalyzerThread() : juce::TimeSliceThread("EQ Spectrum Analyzer") { startThread(); }
+        ~AnalyzerThread() override { stopThread(1000); }
+    };
+
+    static constexpr int fifoSize = 2 << maxFFTOrder;   // room for two of the largest FFTs before blocks get dropped
+    static constexpr int numPoints = 256;               // points per spectrum path, spaced evenly on the log frequency axis
+    static constexpr int numResponsePoints = 512;       // points per response path, the curve has sharper corners
+    static constexpr int activeIntervalMs = 10, idleIntervalMs = 30;
+
+    struct TapState
+    {
+        juce::AbstractFifo fifo{ fifoSize };
+        std::vector<float> fifoData = std::vector<float>((size_t) fifoSize);
+
+        std::vector<float> history;                 // analyzer thread only: the last fftSize samples
+        std::vector<float> average, peakHold;       // analyzer thread only: per bin, in dB
+    };
+
+    juce::AudioProcessorValueTreeState& apvts;
+    std::atomic<float>* enabledParameter = nullptr;
+    std::array<TapState, numTaps> taps;
+
+    std::atomic<int> numViews{ 0 };
+    std::atomic<int> fftOrder{ 12 };
+    std::atomic<float> averagingSeconds{ 0.2f }, peakHoldDecay{ 12.0f };
+    std::atomic<juce::uint32> requestedResponseVersion{ 0 };
+
+    // analyzer thread only
+    double sampleRate = 44100.0, chainSampleRate = 44100.0;
+    int currentOrder = 0;
+    bool wasActive = false, framePending = true;
+    juce::uint32 responseDesignedVersion = 0;
+    juce::uint64 responseVersion = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    std::vector<float> fftData;
+    std::vector<std::pair<int, int>> pointBins;   // first and last FFT bin behind each path point
+
+    // per response point: cos/sin of w and 2w, and the running complex response of the chain
+    std::vector<double> cosines, cosines2, sines, sines2, responseReal, responseImag;
+
+    juce::SharedResourcePointer<AnalyzerThread> analyzerThread;
+    FramePool frames;
+    juce::CriticalSection registrationLock;   // prepare vs. views coming and going, never taken on the audio thread
+    bool isRegistered = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
+
+//==============================================================================
+template <typename SampleType>
+void SpectrumAnalyzer::pushSamples(Tap tap, const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    auto& state = taps[(size_t) tap];
+    const auto numSamples = buffer.getNumSamples();
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    if (numChannels <= 0 || state.fifo.getFreeSpace() < numSamples)
+        return;   // the analyzer thread is behind, losing a block only costs a little accuracy
+
+    const auto gain = 1.0f / (float) numChannels;
+    const auto scope = state.fifo.write(numSamples);
+
+    auto mixInto = [&](int fifoStart, int size, int bufferStart)
+    {
+        auto* destination = state.fifoData.data() + fifoStart;
+
+        for (int i = 0; i < size; ++i)
+            destination[i] = 0.0f;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = buffer.getReadPointer(channel, bufferStart);
+            for (int i = 0; i < size; ++i)
+                destination[i] += static_cast<float>(source[i]) * gain;
+        }
+    };
+
+    mixInto(scope.startIndex1, scope.blockSize1, 0);
+    mixInto(scope.startIndex2, scope.blockSize2, scope.blockSize1);
+}
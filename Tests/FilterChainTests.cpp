@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    This file contains the tests of SIMDFilterChain against a reference built
+    from juce::dsp::IIR::Filter, one filter per section and channel.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../SIMDFilterChain.h"
+
+//==============================================================================
+namespace
+{
+    using Coefficients = std::array<double, 6>;   // b0, b1, b2, a0, a1, a2, what setStageSections takes
+
+    /*  The scalar chain the SIMD one claims to match: every section an IIR::Filter run with processSample (process()
+        would flush small states to zero at the end of the block, see the SIMDFilterChain docs), and a stage that
+        is switched on or off crossfaded the same way, input + (output - input) * mix.
+    */
+    template <typename SampleType>
+    class ReferenceChain
+    {
+    public:
+        ReferenceChain(double sampleRate, int numChannelsToUse, int numStages)
+            : numChannels(numChannelsToUse), stages((size_t) numStages)
+        {
+            for (auto& stage : stages)
+            {
+                stage.mix.reset(sampleRate, fadeSeconds);
+                stage.mix.setCurrentAndTargetValue(SampleType(1));
+                stage.filters.resize((size_t) numChannels);
+
+                for (auto& channelFilters : stage.filters)
+                    channelFilters = std::vector<juce::dsp::IIR::Filter<SampleType>>((size_t) SIMDFilterChain<SampleType>::maxSectionsPerStage);
+            }
+        }
+
+        void setStageSections(int stageIndex, const std::vector<Coefficients>& sections)
+        {
+            auto& stage = stages[(size_t) stageIndex];
+
+            // like the bank's sections, new coefficients carry on from the state the filters had, and a section
+            // that isn't used for a while keeps its state until it's used again
+            stage.numSections = sections.size();
+
+            for (auto& channelFilters : stage.filters)
+            {
+                for (size_t i = 0; i < sections.size(); ++i)
+                {
+                    const auto& c = sections[i];
+                    channelFilters[i].coefficients = new juce::dsp::IIR::Coefficients<SampleType>(
+                        static_cast<SampleType>(c[0]), static_cast<SampleType>(c[1]), static_cast<SampleType>(c[2]),
+                        static_cast<SampleType>(c[3]), static_cast<SampleType>(c[4]), static_cast<SampleType>(c[5]));
+                }
+            }
+        }
+
+        void setStageActive(int stageIndex, bool shouldBeActive)
+        {
+            auto& stage = stages[(size_t) stageIndex];
+
+            if (stage.active == shouldBeActive)
+                return;
+
+            if (shouldBeActive && stage.mix.getCurrentValue() == SampleType(0))
+                for (auto& channelFilters : stage.filters)
+                    for (auto& filter : channelFilters)
+                        filter.reset();
+
+            stage.active = shouldBeActive;
+            stage.mix.setTargetValue(shouldBeActive ? SampleType(1) : SampleType(0));
+        }
+
+        void process(juce::AudioBuffer<SampleType>& buffer, int numSamples)
+        {
+            std::vector<SampleType> gains((size_t) numSamples);
+
+            for (auto& stage : stages)
+            {
+                const auto isFading = stage.mix.isSmoothing();
+
+                if (! isFading && ! stage.active)
+                    continue;
+
+                if (isFading)
+                    for (auto& gain : gains)
+                        gain = stage.mix.getNextValue();
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    auto* samples = buffer.getWritePointer(channel);
+
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const auto input = samples[i];
+                        auto output = input;
+
+                        for (size_t section = 0; section < stage.numSections; ++section)
+                            output = stage.filters[(size_t) channel][section].processSample(output);
+
+                        samples[i] = isFading ? input + (output - input) * gains[(size_t) i] : output;
+                    }
+                }
+            }
+        }
+
+    private:
+        static constexpr double fadeSeconds = 0.01;   // SIMDFilterChain's
+
+        struct Stage
+        {
+            std::vector<std::vector<juce::dsp::IIR::Filter<SampleType>>> filters;   // per channel, maxSectionsPerStage each
+            size_t numSections = 0;
+            juce::SmoothedValue<SampleType> mix;
+            bool active = true;
+        };
+
+        int numChannels;
+        std::vector<Stage> stages;
+    };
+
+    //==============================================================================
+    // a stage of 1 to maxSectionsPerStage sections: high passes, peaks and low passes all over the spectrum
+    std::vector<Coefficients> makeRandomSections(juce::Random& random, double sampleRate)
+    {
+        std::vector<Coefficients> sections((size_t) 1 + (size_t) random.nextInt(SIMDFilterChain<float>::maxSectionsPerStage));
+
+        for (auto& section : sections)
+        {
+            const auto frequency = 20.0 * std::pow(1000.0, random.nextDouble());   // 20 Hz to 20 kHz
+            const auto quality = 0.3 + 4.0 * random.nextDouble();
+
+            switch (random.nextInt(3))
+            {
+            case 0:  section = juce::dsp::IIR::ArrayCoefficients<double>::makeHighPass(sampleRate, frequency, quality); break;
+            case 1:  section = juce::dsp::IIR::ArrayCoefficients<double>::makeLowPass(sampleRate, frequency, quality); break;
+            default: section = juce::dsp::IIR::ArrayCoefficients<double>::makePeakFilter(sampleRate, frequency, quality,
+                                                                                         juce::Decibels::decibelsToGain(24.0 * random.nextDouble() - 12.0));
+                     break;
+            }
+        }
+
+        return sections;
+    }
+
+    class FilterChainTest  : public juce::UnitTest
+    {
+    public:
+        FilterChainTest() : juce::UnitTest("SIMDFilterChain", "DSP") {}
+
+        void runTest() override
+        {
+            for (auto numChannels : { 1, 2, 3, 5 })   // a partial group and more than one group, for floats and doubles
+            {
+                beginTest("Bit-identical to IIR::Filter, " + juce::String(numChannels) + " channels");
+                runAgainstReference<float>(numChannels, SIMDFilterChain<float>::numStages, false);
+                runAgainstReference<double>(numChannels, SIMDFilterChain<double>::numStages, false);
+            }
+
+            // six stages of up to four sections are longer than the longest unrolled cascade, so the bank splits them,
+            // and switching stages off and on again crossfades between chains of different lengths
+            for (auto numChannels : { 2, 3 })
+            {
+                beginTest("Six stages, fading between stage counts, " + juce::String(numChannels) + " channels");
+                runAgainstReference<float>(numChannels, 6, true);
+                runAgainstReference<double>(numChannels, 6, true);
+            }
+        }
+
+    private:
+        template <typename SampleType>
+        void runAgainstReference(int numChannels, int numStages, bool switchStages)
+        {
+            constexpr double sampleRate = 48000.0;
+            constexpr int maximumBlockSize = 512, numBlocks = 300;
+
+            juce::Random random(0x5eed + numChannels * 16 + numStages);
+
+            SIMDFilterChain<SampleType> chain;
+            chain.prepare(sampleRate, maximumBlockSize, numChannels, numStages);
+            ReferenceChain<SampleType> reference(sampleRate, numChannels, numStages);
+
+            auto setSections = [&](int stage)
+            {
+                const auto sections = makeRandomSections(random, sampleRate);
+                chain.setStageSections(stage, sections.data(), (int) sections.size());
+                reference.setStageSections(stage, sections);
+            };
+
+            for (int stage = 0; stage < numStages; ++stage)
+                setSections(stage);
+
+            juce::AudioBuffer<SampleType> buffer(numChannels, maximumBlockSize), expected(numChannels, maximumBlockSize);
+            int numMismatches = 0;
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                if (block % 40 == 20)
+                    setSections(random.nextInt(numStages));   // new coefficients on running state
+
+                if (switchStages && block % 50 == 25)
+                {
+                    // keep the first few stages, the rest fade out, or back in, from wherever their last fade got to
+                    const auto numActive = juce::jmax(1, numStages - 1 - random.nextInt(numStages - 1));
+
+                    for (int stage = 0; stage < numStages; ++stage)
+                    {
+                        chain.setStageActive(stage, stage < numActive);
+                        reference.setStageActive(stage, stage < numActive);
+                    }
+                }
+
+                // block sizes all over the place, so fades end in the middle of blocks too
+                const auto numSamples = 1 + random.nextInt(maximumBlockSize);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int i = 0; i < numSamples; ++i)
+                        buffer.setSample(channel, i, static_cast<SampleType>(random.nextFloat() * 0.5f - 0.25f));
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    expected.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+
+                auto chainBlock = juce::dsp::AudioBlock<SampleType>(buffer).getSubBlock(0, (size_t) numSamples);
+                chain.process(chainBlock);
+                reference.process(expected, numSamples);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int i = 0; i < numSamples; ++i)
+                        if (buffer.getSample(channel, i) != expected.getSample(channel, i))
+                            ++numMismatches;
+            }
+
+            expectEquals(numMismatches, 0, juce::String(std::is_same_v<SampleType, float> ? "float" : "double")
+                                                + " samples that differ from the reference");
+        }
+    };
+
+    static FilterChainTest filterChainTest;
+}
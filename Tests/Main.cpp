@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    This file contains the entry point of the tests, a console app that runs
+    every juce::UnitTest linked into it, this file's and those of the other
+    .cpp files in Tests/, and exits with a non-zero status on any failure.
+
+    This repository has no project or build files for it, nor for the other
+    console tools: like the renderer and the benchmarks, it is meant to be a
+    console app compiling this file together with the plugin's own sources,
+    and until a project adds one nothing builds or runs these tests. It has to
+    be built with EQ_REALTIME_AUDIT=1, otherwise the realtime safety test fails
+    straight away rather than passing without having watched anything.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "RealtimeAuditSweep.h"
+
+//==============================================================================
+namespace
+{
+    // processBlock and the realtime part of prepareToPlay must not allocate, lock or block, whatever the parameters do
+    class RealtimeSafetyTest  : public juce::UnitTest
+    {
+    public:
+        RealtimeSafetyTest() : juce::UnitTest("Realtime safety", "Audit") {}
+
+        void runTest() override
+        {
+            beginTest("Automation sweeps through the processor");
+
+            expect(RealtimeSafetyAudit::isEnabled, "built without EQ_REALTIME_AUDIT=1, nothing would be audited");
+
+            if (! RealtimeSafetyAudit::isEnabled)
+                return;
+
+            RealtimeSafetyAudit::resetViolations();
+            expectEquals(runRealtimeAuditSweeps(), 0, "the processor refused a channel layout, so that sweep never ran");
+
+            // every violation has been printed with its stack trace already
+            expectEquals(RealtimeSafetyAudit::getNumViolations(), 0, "the audio callback allocated, locked or blocked");
+        }
+    };
+
+    static RealtimeSafetyTest realtimeSafetyTest;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ignoreUnused(argc, argv);
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runAllTests();
+
+    auto numFailures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    std::cout << (numFailures == 0 ? "all tests passed" : juce::String(numFailures) + " failures") << std::endl;
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    This file contains the automation sweeps the realtime safety audit runs
+    through NewProjectAudioProcessor, shared by the tests and the benchmarks'
+    --realtime-audit mode.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+
+//==============================================================================
+// hosts move parameters from other threads and between callbacks, so the parameter changes happen
+// outside the guarded section, and everything the processor does in response inside the callback is audited;
+// false if the processor didn't take the channel count, nothing has been swept then
+template <typename SampleType>
+inline bool runRealtimeAuditSweep(int numChannels, int blockSize, juce::Random& random)
+{
+    NewProjectAudioProcessor processor;
+
+    if (! processor.setMainBusLayout(juce::AudioChannelSet::canonicalChannelSet(numChannels)))
+        return false;
+
+    processor.setProcessingPrecision(std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                        : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(48000.0, blockSize);
+    processor.prepareToPlay(48000.0, blockSize);
+
+    juce::AudioBuffer<SampleType> buffer(processor.getTotalNumInputChannels(), blockSize);
+    juce::MidiBuffer midi;
+    const auto& parameters = processor.getParameters();
+
+    for (int block = 0; block < 4000; ++block)
+    {
+        // every parameter gets hit, slopes, bypasses and the smoothing mode included
+        auto* parameter = parameters[random.nextInt(parameters.size())];
+        parameter->setValueNotifyingHost(random.nextFloat());
+
+        // every fourth stretch of blocks is silent, long enough to go idle and wake up again
+        const auto isSilentStretch = (block / 250) % 4 == 3;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample(channel, i, isSilentStretch ? SampleType(0) : static_cast<SampleType>(random.nextFloat() * 0.5f - 0.25f));
+
+        processor.processBlock(buffer, midi);
+
+        if (block % 16 == 0)
+        {
+            juce::Thread::sleep(1);   // gives the designer thread time to hand new sets over, so that path is exercised too
+
+            // there is no message loop here, so this is where the processor's timer would have fired: oversampling
+            // and linear-phase switches are set up and the realtime part of that is audited as well
+            processor.applyPendingSetupChange();
+        }
+
+        if (block % 1000 == 999)
+            processor.prepareToPlay(48000.0, blockSize);   // the realtime part of prepareToPlay is audited as well
+    }
+
+    processor.releaseResources();
+    return true;
+}
+
+// every precision at a few channel counts and block sizes, the violations add up in RealtimeSafetyAudit;
+// returns how many of those setups the processor refused, which should be none
+inline int runRealtimeAuditSweeps()
+{
+    juce::Random random(0x5eed);
+    int numRefused = 0;
+
+    for (auto numChannels : { 1, 2, 8 })
+    {
+        for (auto blockSize : { 32, 512 })
+        {
+            numRefused += runRealtimeAuditSweep<float>(numChannels, blockSize, random) ? 0 : 1;
+            numRefused += runRealtimeAuditSweep<double>(numChannels, blockSize, random) ? 0 : 1;
+        }
+    }
+
+    return numRefused;
+}